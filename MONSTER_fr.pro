@@ -5,6 +5,7 @@ TEMPLATE = app
 VERSION = 3.0.0
 
 QT += \
+    concurrent \
     core \
     multimedia
 QT -= \
@@ -14,8 +15,14 @@ CONFIG += \
     c++11 \
     console
 
+# Lowest log level compiled in (0: debug, 1: info, 2: warning, 3: error), e.g. qmake LOG_MINIMUM_LEVEL=1
+isEmpty(LOG_MINIMUM_LEVEL) {
+    LOG_MINIMUM_LEVEL = 0
+}
+
 DEFINES += \
-    SW_VERSION=\\\"$$VERSION\\\"
+    SW_VERSION=\\\"$$VERSION\\\" \
+    LOG_MINIMUM_LEVEL=$$LOG_MINIMUM_LEVEL
 
 CONFIG(debug, debug|release) {
     DESTDIR = $${OUT_PWD}/debug
@@ -64,17 +71,55 @@ win32 {
 HEADERS += \
     applicationmanager.h \
     applicationutils.h \
+    atomicrename.h \
     base.h \
+    directoryreader.h \
+    directorywalker.h \
+    duplicatecheck.h \
+    boundedqueue.h \
+    exifreader.h \
     filerenamer.h \
-    logmanager.h
+    filterrules.h \
+    filterset.h \
+    imageformat.h \
+    logmanager.h \
+    logwriter.h \
+    matchedfile.h \
+    metadatacache.h \
+    namereservation.h \
+    nametemplate.h \
+    nametimestampdecoder.h \
+    renamejournal.h \
+    renamepipeline.h \
+    renameplan.h \
+    renamestatistics.h \
+    windowedfileio.h
 
 SOURCES += \
     applicationmanager.cpp \
     applicationutils.cpp \
+    atomicrename.cpp \
     base.cpp \
+    directoryreader.cpp \
+    directorywalker.cpp \
+    duplicatecheck.cpp \
+    exifreader.cpp \
     filerenamer.cpp \
+    filterrules.cpp \
+    filterset.cpp \
+    imageformat.cpp \
     logmanager.cpp \
-    main.cpp
+    logwriter.cpp \
+    metadatacache.cpp \
+    main.cpp \
+    namereservation.cpp \
+    nametemplate.cpp \
+    nametimestampdecoder.cpp \
+    renamejournal.cpp \
+    renamepipeline.cpp \
+    renameplan.cpp \
+    renamestatistics.cpp \
+    windowedfileio.cpp
 
 win32 {
     CONFIG(debug, debug|release) {
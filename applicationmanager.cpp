@@ -1,26 +1,55 @@
+// Std
+#include <cstdio>
+
 // Qt
 #include <QFileInfo>
+#include <QFile>
 #include <QDir>
+#include <QThread>
+
+// Exiv2
+#include <exiv2/exiv2.hpp>
 
 // Local
 #include "applicationmanager.h"
 
+QMutex ApplicationManager::m_xmpMutex;
+
 ApplicationManager::ApplicationManager(const QStringList &arguments, QObject *parent) :
     Base("AM", parent),
     m_fileRenamer(this),
-    m_arguments(arguments)
+    m_arguments(arguments),
+    m_jobCount(1),
+    m_planFilePath(),
+    m_applyFilePath(),
+    m_journalFilePath(),
+    m_resumeFilePath(),
+    m_undoFilePath(),
+    m_cacheFilePath(),
+    m_statisticsEnabled(false),
+    m_recursive(false),
+    m_fromStdin(false),
+    m_nulSeparated(false)
 {
-    this->debug("Application manager created");
+    LOG_DEBUG("Application manager created");
 }
 
 ApplicationManager::~ApplicationManager()
 {
-    this->debug("Application manager disposed of");
+    Exiv2::XmpParser::terminate();
+
+    LOG_DEBUG("Application manager disposed of");
 }
 
 void ApplicationManager::initialize()
 {
-    this->debug("Initialized");
+    // Initialize the XMP toolkit up front with a lock, Exiv2 may then be used from several threads.
+    if (!Exiv2::XmpParser::initialize(ApplicationManager::xmpLockUnlock, &m_xmpMutex))
+    {
+        LOG_WARNING("Cannot initialize the XMP toolkit");
+    }
+
+    LOG_DEBUG("Initialized");
 }
 
 int ApplicationManager::exec()
@@ -31,24 +60,135 @@ int ApplicationManager::exec()
     bool ret_val = this->parseArguments(directories, files);
     if (!ret_val)
     {
-        this->error("Error parsing arguments");
+        LOG_ERROR("Error parsing arguments");
 
         return EXIT_FAILURE;
     }
 
-    // Process directories.
-    m_fileRenamer.processDirectories(directories);
+    // Configure the file renamer.
+    m_fileRenamer.setJobCount(m_jobCount);
+    m_fileRenamer.setStatisticsEnabled(m_statisticsEnabled);
+    m_fileRenamer.setRecursive(m_recursive);
 
-    // Process files.
-    m_fileRenamer.processFiles(files);
+    LOG_DEBUG("Jobs: " + QString::number(m_fileRenamer.jobCount()));
 
-    this->debug("================");
+    if (!m_undoFilePath.isEmpty())
+    {
+        // Reverse a previous run.
+        LOG_DEBUG("Undoing rename journal: " + m_undoFilePath);
+
+        if (!m_fileRenamer.undoJournal(m_undoFilePath))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else if (!m_applyFilePath.isEmpty())
+    {
+        // Apply a previously computed plan.
+        LOG_DEBUG("Applying rename plan: " + m_applyFilePath);
+
+        if (!m_fileRenamer.applyPlan(m_applyFilePath))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        // In planning mode, record the renames instead of performing them.
+        if (!m_planFilePath.isEmpty())
+        {
+            LOG_DEBUG("Writing rename plan: " + m_planFilePath);
 
-    this->debug("Files renamed: " + QString::number(m_fileRenamer.renamedFileCount()) + "/" + QString::number(m_fileRenamer.totalFileCount()));
+            if (!m_fileRenamer.openPlan(m_planFilePath))
+            {
+                LOG_ERROR("Cannot create the rename plan: " + m_planFilePath);
 
-    this->debug("Done");
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Log the renames to the journal, finishing an interrupted run first when resuming.
+        if (!m_resumeFilePath.isEmpty())
+        {
+            LOG_DEBUG("Resuming from rename journal: " + m_resumeFilePath);
+
+            if (!m_fileRenamer.resumeJournal(m_resumeFilePath) || !m_fileRenamer.openJournal(m_resumeFilePath, true))
+            {
+                LOG_ERROR("Cannot resume from the rename journal: " + m_resumeFilePath);
+
+                return EXIT_FAILURE;
+            }
+        }
+        else if (!m_journalFilePath.isEmpty())
+        {
+            LOG_DEBUG("Writing rename journal: " + m_journalFilePath);
+
+            if (!m_fileRenamer.openJournal(m_journalFilePath, false))
+            {
+                LOG_ERROR("Cannot create the rename journal: " + m_journalFilePath);
+
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Reuse the timestamps extracted by previous runs.
+        if (!m_cacheFilePath.isEmpty())
+        {
+            LOG_DEBUG("Using metadata cache: " + m_cacheFilePath);
+
+            m_fileRenamer.openMetadataCache(m_cacheFilePath);
+        }
+
+        // Process directories.
+        m_fileRenamer.processDirectories(directories);
+
+        // Process files.
+        m_fileRenamer.processFiles(files);
+
+        // Process the files listed on the standard input, one per line or NUL-separated.
+        if (m_fromStdin)
+        {
+            QFile standard_input;
+            if (!standard_input.open(stdin, QIODevice::ReadOnly))
+            {
+                LOG_ERROR("Cannot read the standard input");
 
-    return m_fileRenamer.renamedFileCount() == m_fileRenamer.totalFileCount() ? EXIT_SUCCESS : EXIT_FAILURE;
+                return EXIT_FAILURE;
+            }
+
+            m_fileRenamer.processFileList(standard_input, m_nulSeparated ? '\0' : '\n');
+        }
+
+        m_fileRenamer.closeJournal();
+        m_fileRenamer.closePlan();
+        if (!m_cacheFilePath.isEmpty() && !m_fileRenamer.closeMetadataCache())
+        {
+            LOG_WARNING("Cannot save the metadata cache: " + m_cacheFilePath);
+        }
+
+        LOG_DEBUG("Journal syncs: " + QString::number(m_fileRenamer.journalSyncCount()));
+        LOG_DEBUG("Duplicates: " + QString::number(m_fileRenamer.duplicateCount()));
+    }
+
+    LOG_DEBUG("================");
+
+    LOG_DEBUG("Files renamed: " + QString::number(m_fileRenamer.renamedFileCount()) + "/" + QString::number(m_fileRenamer.totalFileCount()));
+
+    LOG_DEBUG("Name reservation lookups: " + QString::number(m_fileRenamer.nameLookupCount()) + " (directories listed: " + QString::number(m_fileRenamer.nameDirectoryListingCount()) + ")");
+
+    // Report where the time went.
+    if (m_statisticsEnabled)
+    {
+        foreach (const QString &statistics_line, m_fileRenamer.statisticsReport())
+        {
+            LOG_INFO(statistics_line);
+        }
+    }
+
+    LOG_DEBUG("Done");
+
+    // A duplicate that was skipped, linked or quarantined is handled as well as a renamed file.
+    return m_fileRenamer.renamedFileCount() + m_fileRenamer.duplicateCount() == m_fileRenamer.totalFileCount() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 bool ApplicationManager::parseArguments(QList<QDir> &directories, QFileInfoList &files)
@@ -56,7 +196,7 @@ bool ApplicationManager::parseArguments(QList<QDir> &directories, QFileInfoList
     // Check whether the argument list is empty.
     if (m_arguments.empty())
     {
-        this->warning("Empty argument list");
+        LOG_WARNING("Empty argument list");
 
         return false;
     }
@@ -66,7 +206,260 @@ bool ApplicationManager::parseArguments(QList<QDir> &directories, QFileInfoList
     {
         QString argument(m_arguments.at(i));
 
-        this->debug("Processing argument: " + argument);
+        LOG_DEBUG("Processing argument: " + argument);
+
+        // Check whether the argument is an option.
+        if (argument == "-j" || argument == "--jobs")
+        {
+            bool job_count_valid = false;
+            int job_count = m_arguments.value(++i).toInt(&job_count_valid);
+            if (!job_count_valid || job_count < 0)
+            {
+                LOG_WARNING("Invalid job count: " + m_arguments.value(i));
+
+                return false;
+            }
+
+            // Zero means one job per core.
+            m_jobCount = job_count == 0 ? QThread::idealThreadCount() : job_count;
+
+            continue;
+        }
+        if (argument == "--log-level")
+        {
+            LogManager::LogLevel log_level;
+            if (!LogManager::parseLogLevel(m_arguments.value(++i), log_level))
+            {
+                LOG_WARNING("Invalid log level: " + m_arguments.value(i));
+
+                return false;
+            }
+            LogManager::setLogLevel(log_level);
+
+            continue;
+        }
+        if (argument == "--plan" || argument == "--apply")
+        {
+            QString plan_file_path = m_arguments.value(++i);
+            if (plan_file_path.isEmpty())
+            {
+                LOG_WARNING("Missing plan file for " + argument);
+
+                return false;
+            }
+            if (argument == "--plan")
+            {
+                m_planFilePath = plan_file_path;
+            }
+            else
+            {
+                m_applyFilePath = plan_file_path;
+            }
+            if (!m_planFilePath.isEmpty() && !m_applyFilePath.isEmpty())
+            {
+                LOG_WARNING("--plan and --apply cannot be used together");
+
+                return false;
+            }
+
+            continue;
+        }
+        if (argument == "--journal" || argument == "--resume" || argument == "--undo")
+        {
+            QString journal_file_path = m_arguments.value(++i);
+            if (journal_file_path.isEmpty())
+            {
+                LOG_WARNING("Missing journal file for " + argument);
+
+                return false;
+            }
+            if (argument == "--journal")
+            {
+                m_journalFilePath = journal_file_path;
+            }
+            else if (argument == "--resume")
+            {
+                m_resumeFilePath = journal_file_path;
+            }
+            else
+            {
+                m_undoFilePath = journal_file_path;
+            }
+
+            continue;
+        }
+
+        if (argument == "--cache")
+        {
+            m_cacheFilePath = m_arguments.value(++i);
+            if (m_cacheFilePath.isEmpty())
+            {
+                LOG_WARNING("Missing cache file for " + argument);
+
+                return false;
+            }
+
+            continue;
+        }
+        if (argument == "--name-template")
+        {
+            // e.g. "{date}_{time}_{seq}.{ext}", see NameTemplate for the fields.
+            QString name_template = m_arguments.value(++i);
+            if (!m_fileRenamer.setNameTemplate(name_template))
+            {
+                LOG_WARNING("Invalid name template: " + name_template);
+
+                return false;
+            }
+
+            continue;
+        }
+        if (argument == "--archive-root")
+        {
+            // Files are moved to ROOT/yyyy/MM as they are renamed.
+            QString archive_root_path = m_arguments.value(++i);
+            if (archive_root_path.isEmpty())
+            {
+                LOG_WARNING("Missing archive root for " + argument);
+
+                return false;
+            }
+            if (!m_fileRenamer.setArchiveRoot(archive_root_path))
+            {
+                return false;
+            }
+
+            continue;
+        }
+        if (argument == "--duplicates")
+        {
+            // skip, link or quarantine=DIR: what to do with a file whose new name holds an identical copy.
+            QString duplicates_option = m_arguments.value(++i);
+            int separator_index = duplicates_option.indexOf('=');
+            DuplicateCheck::Action duplicate_action;
+            if (!DuplicateCheck::parseAction(duplicates_option.left(separator_index), duplicate_action) ||
+                (duplicate_action == DuplicateCheck::Action_Quarantine) != (separator_index != -1))
+            {
+                LOG_WARNING("Invalid duplicate action: " + duplicates_option);
+
+                return false;
+            }
+            if (!m_fileRenamer.setDuplicateAction(duplicate_action, separator_index != -1 ? duplicates_option.mid(separator_index + 1) : QString()))
+            {
+                return false;
+            }
+
+            continue;
+        }
+        if (argument == "--rules")
+        {
+            // Loaded right away, so a later --name-timestamp finds the filters of the rules file.
+            QString rules_file_path = m_arguments.value(++i);
+            if (rules_file_path.isEmpty())
+            {
+                LOG_WARNING("Missing rules file for " + argument);
+
+                return false;
+            }
+            if (!m_fileRenamer.loadFilterRules(rules_file_path))
+            {
+                LOG_WARNING("Cannot load the filter rules: " + rules_file_path);
+
+                return false;
+            }
+
+            continue;
+        }
+        if (argument == "--stats")
+        {
+            m_statisticsEnabled = true;
+
+            continue;
+        }
+        if (argument == "-r" || argument == "--recursive")
+        {
+            m_recursive = true;
+
+            continue;
+        }
+        if (argument == "--pipeline")
+        {
+            // SCAN,CLASSIFY,EXTRACT thread counts, the commit stage runs on the main thread.
+            QStringList thread_counts = m_arguments.value(++i).split(',');
+            if (thread_counts.count() != RenamePipeline::Stage_Count)
+            {
+                LOG_WARNING("Invalid pipeline thread counts: " + m_arguments.value(i));
+
+                return false;
+            }
+            for (int stage = 0; stage < RenamePipeline::Stage_Count; stage++)
+            {
+                bool thread_count_valid = false;
+                int thread_count = thread_counts.at(stage).toInt(&thread_count_valid);
+                if (!thread_count_valid || thread_count < 0)
+                {
+                    LOG_WARNING("Invalid pipeline thread counts: " + m_arguments.value(i));
+
+                    return false;
+                }
+
+                // Zero means one thread per core.
+                m_fileRenamer.setPipelineThreadCount(static_cast<RenamePipeline::Stage>(stage), thread_count == 0 ? QThread::idealThreadCount() : thread_count);
+            }
+            m_fileRenamer.setPipelineEnabled(true);
+
+            continue;
+        }
+        if (argument == "--queue-capacity")
+        {
+            bool queue_capacity_valid = false;
+            int queue_capacity = m_arguments.value(++i).toInt(&queue_capacity_valid);
+            if (!queue_capacity_valid || queue_capacity < 2)
+            {
+                LOG_WARNING("Invalid queue capacity: " + m_arguments.value(i));
+
+                return false;
+            }
+            m_fileRenamer.setPipelineQueueCapacity(queue_capacity);
+
+            continue;
+        }
+        if (argument == "--from-stdin")
+        {
+            m_fromStdin = true;
+
+            continue;
+        }
+        if (argument == "-0")
+        {
+            // Only the standard input list is NUL-separated, so -0 implies --from-stdin.
+            m_fromStdin = true;
+            m_nulSeparated = true;
+
+            continue;
+        }
+        if (argument == "--name-timestamp")
+        {
+            // [FILTER=]MODE, without a filter the mode applies to all of them.
+            QString name_timestamp_option = m_arguments.value(++i);
+            int separator_index = name_timestamp_option.lastIndexOf('=');
+            QString filter_name = separator_index != -1 ? name_timestamp_option.left(separator_index) : QString();
+            NameTimestampDecoder::Mode name_timestamp_mode;
+            if (!NameTimestampDecoder::parseMode(name_timestamp_option.mid(separator_index + 1), name_timestamp_mode))
+            {
+                LOG_WARNING("Invalid file name timestamp mode: " + name_timestamp_option);
+
+                return false;
+            }
+            if (!m_fileRenamer.setNameTimestampMode(filter_name, name_timestamp_mode))
+            {
+                LOG_WARNING("No filter with a file name timestamp: " + filter_name);
+
+                return false;
+            }
+
+            continue;
+        }
 
         // Check whether the argument is a directory or a file (or neither).
         QFileInfo argument_file_info(argument);
@@ -80,7 +473,7 @@ bool ApplicationManager::parseArguments(QList<QDir> &directories, QFileInfoList
         // Check whether the argument is a directory.
         if (argument_file_info.isDir())
         {
-            this->debug("Directory");
+            LOG_DEBUG("Directory");
 
             // Append the argument to the list of directories.
             directories.append(QDir(argument));
@@ -89,7 +482,7 @@ bool ApplicationManager::parseArguments(QList<QDir> &directories, QFileInfoList
         // Check whether the argument is a file.
         else if (argument_file_info.isFile())
         {
-            this->debug("File");
+            LOG_DEBUG("File");
 
             // Append the argument to the list of files.
             files.append(argument_file_info);
@@ -98,3 +491,16 @@ bool ApplicationManager::parseArguments(QList<QDir> &directories, QFileInfoList
 
     return true;
 }
+
+void ApplicationManager::xmpLockUnlock(void *lockData, bool lockUnlock)
+{
+    QMutex *xmp_mutex = static_cast<QMutex *>(lockData);
+    if (lockUnlock)
+    {
+        xmp_mutex->lock();
+    }
+    else
+    {
+        xmp_mutex->unlock();
+    }
+}
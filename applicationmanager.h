@@ -4,6 +4,7 @@
 // Qt
 #include <QObject>
 #include <QFileInfoList>
+#include <QMutex>
 #include <QDebug>
 
 // Local
@@ -15,8 +16,20 @@ class ApplicationManager : public Base
     Q_OBJECT
 
 private:
+    static QMutex m_xmpMutex;
     FileRenamer m_fileRenamer;
     QStringList m_arguments;
+    int m_jobCount;
+    QString m_planFilePath;
+    QString m_applyFilePath;
+    QString m_journalFilePath;
+    QString m_resumeFilePath;
+    QString m_undoFilePath;
+    QString m_cacheFilePath;
+    bool m_statisticsEnabled;
+    bool m_recursive;
+    bool m_fromStdin;
+    bool m_nulSeparated;
 
 public:
     explicit ApplicationManager(const QStringList &arguments, QObject *parent = NULL);
@@ -26,6 +39,9 @@ public:
     void initialize();
     int exec();
     bool parseArguments(QList<QDir> &directories, QFileInfoList &files);
+
+private:
+    static void xmpLockUnlock(void *lockData, bool lockUnlock);
 };
 
 #endif // APPLICATIONMANAGER_H
@@ -0,0 +1,227 @@
+// Qt
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+// Posix
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Local
+#include "atomicrename.h"
+
+#if defined(Q_OS_LINUX) && !defined(RENAME_NOREPLACE)
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
+AtomicRename::AtomicRename() :
+    m_directoryPath(),
+    m_directoryFd(-1)
+{
+}
+
+AtomicRename::~AtomicRename()
+{
+    this->closeDirectory();
+}
+
+AtomicRename::AtomicRename_RetVal AtomicRename::rename(const QString &filePath, const QString &newFilePath)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_renameat2)
+    QFileInfo file_info(filePath);
+    QFileInfo new_file_info(newFilePath);
+
+    // Rename relative to the directory when both names are in the same one, which is the usual case.
+    int directory_fd = AT_FDCWD;
+    QByteArray file_path = QFile::encodeName(file_info.absoluteFilePath());
+    QByteArray new_file_path = QFile::encodeName(new_file_info.absoluteFilePath());
+    if (file_info.absolutePath() == new_file_info.absolutePath() && this->openDirectory(file_info.absolutePath()))
+    {
+        directory_fd = m_directoryFd;
+        file_path = QFile::encodeName(file_info.fileName());
+        new_file_path = QFile::encodeName(new_file_info.fileName());
+    }
+
+    // The glibc wrapper is recent, call the kernel directly.
+    if (syscall(SYS_renameat2, directory_fd, file_path.constData(), directory_fd, new_file_path.constData(), RENAME_NOREPLACE) == 0)
+    {
+        return AtomicRename_Success;
+    }
+    if (errno == EEXIST)
+    {
+        return AtomicRename_Exists;
+    }
+    if (errno == EXDEV)
+    {
+        return AtomicRename::copyRename(filePath, newFilePath);
+    }
+    if (errno != ENOSYS && errno != EINVAL)
+    {
+        return AtomicRename_Error;
+    }
+
+    // The kernel or the filesystem does not support RENAME_NOREPLACE.
+#endif
+
+    return AtomicRename::fallbackRename(filePath, newFilePath);
+}
+
+void AtomicRename::closeDirectory()
+{
+#ifdef Q_OS_LINUX
+    if (m_directoryFd != -1)
+    {
+        ::close(m_directoryFd);
+    }
+#endif
+    m_directoryFd = -1;
+    m_directoryPath.clear();
+}
+
+bool AtomicRename::openDirectory(const QString &directoryPath)
+{
+#ifdef Q_OS_LINUX
+    if (m_directoryFd != -1 && m_directoryPath == directoryPath)
+    {
+        return true;
+    }
+
+    this->closeDirectory();
+
+    m_directoryFd = ::open(QFile::encodeName(directoryPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_directoryFd == -1)
+    {
+        return false;
+    }
+    m_directoryPath = directoryPath;
+
+    return true;
+#else
+    Q_UNUSED(directoryPath);
+
+    return false;
+#endif
+}
+
+AtomicRename::AtomicRename_RetVal AtomicRename::fallbackRename(const QString &filePath, const QString &newFilePath)
+{
+    // QFile::rename refuses to replace an existing file, only check which way it failed.
+    if (QFile::rename(filePath, newFilePath))
+    {
+        return AtomicRename_Success;
+    }
+
+    return QFileInfo::exists(newFilePath) ? AtomicRename_Exists : AtomicRename_Error;
+}
+
+AtomicRename::AtomicRename_RetVal AtomicRename::copyRename(const QString &filePath, const QString &newFilePath)
+{
+#ifdef Q_OS_LINUX
+    int fd = ::open(QFile::encodeName(filePath).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return AtomicRename_Error;
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0)
+    {
+        ::close(fd);
+
+        return AtomicRename_Error;
+    }
+
+    // O_EXCL keeps the no-replace promise of the rename.
+    QByteArray new_file_path = QFile::encodeName(newFilePath);
+    int new_fd = ::open(new_file_path.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, file_stat.st_mode & 07777);
+    if (new_fd == -1)
+    {
+        bool exists = errno == EEXIST;
+        ::close(fd);
+
+        return exists ? AtomicRename_Exists : AtomicRename_Error;
+    }
+
+    // Keep the modification time, the file time is the timestamp of last resort.
+    struct timespec times[2] = { file_stat.st_atim, file_stat.st_mtim };
+    bool copied = AtomicRename::copyData(fd, new_fd, file_stat.st_size) && ::futimens(new_fd, times) == 0 && ::fsync(new_fd) == 0;
+    copied = ::close(new_fd) == 0 && copied;
+    ::close(fd);
+
+    // Only remove the original once the copy is safely on disk.
+    if (!copied || ::unlink(QFile::encodeName(filePath).constData()) != 0)
+    {
+        ::unlink(new_file_path.constData());
+
+        return AtomicRename_Error;
+    }
+
+    return AtomicRename_Success;
+#else
+    return AtomicRename::fallbackRename(filePath, newFilePath);
+#endif
+}
+
+bool AtomicRename::copyData(int fd, int newFd, qint64 size)
+{
+#ifdef Q_OS_LINUX
+#ifdef FICLONE
+    // Filesystems sharing extents across mount points (Btrfs subvolumes, XFS with reflink) copy nothing at all.
+    if (::ioctl(newFd, FICLONE, fd) == 0)
+    {
+        return true;
+    }
+#endif
+
+    qint64 copied_size = 0;
+#ifdef SYS_copy_file_range
+    // Let the kernel copy without going through user space.
+    while (copied_size < size)
+    {
+        ssize_t chunk_size = syscall(SYS_copy_file_range, fd, NULL, newFd, NULL, static_cast<size_t>(size - copied_size), 0u);
+        if (chunk_size <= 0)
+        {
+            break;
+        }
+        copied_size += chunk_size;
+    }
+    if (copied_size == size)
+    {
+        return true;
+    }
+#else
+    Q_UNUSED(size);
+#endif
+
+    // Older kernels cannot copy_file_range between filesystems, carry on with plain reads and writes.
+    char buffer[64 * 1024];
+    for (;;)
+    {
+        ssize_t read_size = ::pread(fd, buffer, sizeof(buffer), copied_size);
+        if (read_size < 0)
+        {
+            return false;
+        }
+        if (read_size == 0)
+        {
+            return true;
+        }
+        if (::pwrite(newFd, buffer, read_size, copied_size) != read_size)
+        {
+            return false;
+        }
+        copied_size += read_size;
+    }
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(newFd);
+    Q_UNUSED(size);
+
+    return false;
+#endif
+}
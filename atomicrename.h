@@ -0,0 +1,47 @@
+#ifndef ATOMICRENAME_H
+#define ATOMICRENAME_H
+
+// Qt
+#include <QString>
+
+// Renames files without ever replacing an existing one, and tells a taken name apart from other failures.
+// On Linux the check and the rename are one renameat2(RENAME_NOREPLACE) call relative to a directory
+// descriptor kept open across the renames of a directory, so no stat is needed and two instances
+// working on the same directory cannot overwrite each other's files.
+// Elsewhere, or on filesystems without RENAME_NOREPLACE, QFile::rename is used.
+// A rename to another filesystem becomes a copy, a reflink where the filesystem shares extents,
+// otherwise an in-kernel copy_file_range, followed by the removal of the original.
+class AtomicRename
+{
+public:
+    enum AtomicRename_RetVal
+    {
+        AtomicRename_Success,
+        AtomicRename_Exists,
+        AtomicRename_Error
+    };
+
+private:
+    QString m_directoryPath;
+    int m_directoryFd;
+
+public:
+    AtomicRename();
+    ~AtomicRename();
+
+private:
+    AtomicRename(const AtomicRename &);
+    AtomicRename &operator=(const AtomicRename &);
+
+public:
+    AtomicRename_RetVal rename(const QString &filePath, const QString &newFilePath);
+    void closeDirectory();
+
+private:
+    bool openDirectory(const QString &directoryPath);
+    static AtomicRename_RetVal fallbackRename(const QString &filePath, const QString &newFilePath);
+    static AtomicRename_RetVal copyRename(const QString &filePath, const QString &newFilePath);
+    static bool copyData(int fd, int newFd, qint64 size);
+};
+
+#endif // ATOMICRENAME_H
@@ -0,0 +1,131 @@
+TARGET = MONSTER_fr_benchmark
+
+TEMPLATE = app
+
+VERSION = 3.0.0
+
+QT += \
+    concurrent \
+    core \
+    multimedia
+QT -= \
+    gui
+
+CONFIG += \
+    c++11 \
+    console
+
+# Lowest log level compiled in (0: debug, 1: info, 2: warning, 3: error), e.g. qmake LOG_MINIMUM_LEVEL=1
+isEmpty(LOG_MINIMUM_LEVEL) {
+    LOG_MINIMUM_LEVEL = 0
+}
+
+DEFINES += \
+    SW_VERSION=\\\"$$VERSION\\\" \
+    LOG_MINIMUM_LEVEL=$$LOG_MINIMUM_LEVEL
+
+CONFIG(debug, debug|release) {
+    DESTDIR = $${OUT_PWD}/debug
+}
+CONFIG(release, debug|release) {
+    DESTDIR = $${OUT_PWD}/release
+}
+MOC_DIR = $${DESTDIR}/.moc
+OBJECTS_DIR = $${DESTDIR}/.obj
+RCC_DIR = $${DESTDIR}/.rcc
+
+INCLUDEPATH += \
+    "$$PWD/.." \
+    "$$PWD/../include"
+
+win32 {
+    CONFIG(debug, debug|release) {
+        contains(QMAKE_TARGET.arch, x86_64) {
+            # Windows x64 (64bit) debug
+            LIBS += \
+                -L"$$PWD/../lib/win/x64/debug"
+        } else {
+            # Windows x86 (32bit) debug
+            LIBS += \
+                -L"$$PWD/../lib/win/x86/debug"
+        }
+    }
+    CONFIG(release, debug|release) {
+        contains(QMAKE_TARGET.arch, x86_64) {
+            # Windows x64 (64bit) release
+            LIBS += \
+                -L"$$PWD/../lib/win/x64/release"
+        } else {
+            # Windows x86 (32bit) release
+            LIBS += \
+                -L"$$PWD/../lib/win/x86/release"
+        }
+    }
+    LIBS += \
+        -llibexiv2 -lxmpsdk -lzlib1 -llibexpat -lpsapi
+}
+
+HEADERS += \
+    ../applicationutils.h \
+    ../atomicrename.h \
+    ../base.h \
+    ../directoryreader.h \
+    ../directorywalker.h \
+    ../duplicatecheck.h \
+    ../boundedqueue.h \
+    ../exifreader.h \
+    ../filerenamer.h \
+    ../filterrules.h \
+    ../filterset.h \
+    ../imageformat.h \
+    ../logmanager.h \
+    ../logwriter.h \
+    ../matchedfile.h \
+    ../metadatacache.h \
+    ../namereservation.h \
+    ../nametemplate.h \
+    ../nametimestampdecoder.h \
+    ../renamejournal.h \
+    ../renamepipeline.h \
+    ../renameplan.h \
+    ../renamestatistics.h \
+    ../windowedfileio.h \
+    corpusgenerator.h \
+    exifreaderbenchmark.h \
+    filtersetbenchmark.h \
+    journalbenchmark.h \
+    renamerbenchmark.h \
+    rulesbenchmark.h \
+    testimage.h
+
+SOURCES += \
+    ../applicationutils.cpp \
+    ../atomicrename.cpp \
+    ../base.cpp \
+    ../directoryreader.cpp \
+    ../directorywalker.cpp \
+    ../duplicatecheck.cpp \
+    ../exifreader.cpp \
+    ../filerenamer.cpp \
+    ../filterrules.cpp \
+    ../filterset.cpp \
+    ../imageformat.cpp \
+    ../logmanager.cpp \
+    ../logwriter.cpp \
+    ../metadatacache.cpp \
+    ../namereservation.cpp \
+    ../nametemplate.cpp \
+    ../nametimestampdecoder.cpp \
+    ../renamejournal.cpp \
+    ../renamepipeline.cpp \
+    ../renameplan.cpp \
+    ../renamestatistics.cpp \
+    ../windowedfileio.cpp \
+    corpusgenerator.cpp \
+    exifreaderbenchmark.cpp \
+    filtersetbenchmark.cpp \
+    journalbenchmark.cpp \
+    main.cpp \
+    renamerbenchmark.cpp \
+    rulesbenchmark.cpp \
+    testimage.cpp
@@ -0,0 +1,273 @@
+// Qt
+#include <QFile>
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+// Windows
+#include <sys/utime.h>
+#else
+// Posix
+#include <utime.h>
+#endif
+
+// Local
+#include "corpusgenerator.h"
+#include "testimage.h"
+
+const int CorpusGenerator::m_FILTER_COUNT(11);
+
+namespace
+{
+    const char DIGITS[] = "0123456789";
+    const char HEX_DIGITS[] = "0123456789abcdef";
+    const char ALPHANUMERICS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+}
+
+CorpusGenerator::CorpusGenerator(const Options &options) :
+    m_options(options),
+    m_fileNames()
+{
+}
+
+CorpusGenerator::Options CorpusGenerator::defaultOptions()
+{
+    Options options;
+    options.fileCount = 10000;
+    options.exifRatio = 0.8;
+    options.collisionRatio = 0.05;
+    options.nonMatchingRatio = 0.1;
+    options.seed = 1;
+
+    return options;
+}
+
+bool CorpusGenerator::parseOptions(const QStringList &arguments, Options &options, QStringList &remainingArguments)
+{
+    for (int i = 0; i < arguments.count(); i++)
+    {
+        QString argument(arguments.at(i));
+        bool value_valid = true;
+        if (argument == "--count")
+        {
+            options.fileCount = arguments.value(++i).toInt(&value_valid);
+            value_valid = value_valid && options.fileCount > 0;
+        }
+        else if (argument == "--exif")
+        {
+            options.exifRatio = arguments.value(++i).toDouble(&value_valid);
+        }
+        else if (argument == "--collisions")
+        {
+            options.collisionRatio = arguments.value(++i).toDouble(&value_valid);
+        }
+        else if (argument == "--non-matching")
+        {
+            options.nonMatchingRatio = arguments.value(++i).toDouble(&value_valid);
+        }
+        else if (argument == "--seed")
+        {
+            options.seed = arguments.value(++i).toUInt(&value_valid);
+        }
+        else
+        {
+            remainingArguments.append(argument);
+        }
+
+        if (!value_valid)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString CorpusGenerator::usage()
+{
+    return "[--count N] [--exif RATIO] [--collisions RATIO] [--non-matching RATIO] [--seed N]";
+}
+
+int CorpusGenerator::generate(const QDir &directory)
+{
+    qsrand(m_options.seed);
+    m_fileNames.clear();
+
+    QStringList image_suffixes;
+    image_suffixes << "jpg" << "JPG" << "jpeg" << "png" << "gif" << "bmp";
+    QStringList non_matching_names;
+    non_matching_names << "holiday_%1.jpg" << "DSC_%1.NEF" << "notes_%1.txt" << "VID_%1.mp4" << "Screenshot_%1.png";
+
+    // Two minutes apart, so the one-second steps of the collision loop never reach the next file.
+    QDateTime timestamp(QDate(2017, 1, 1), QTime(0, 0, 0));
+    QList<QDateTime> used_timestamps;
+    int created_file_count = 0;
+    for (int i = 0; i < m_options.fileCount; i++)
+    {
+        QString file_name;
+        QByteArray file_data;
+        QDateTime file_timestamp = timestamp;
+        if (CorpusGenerator::randomRatio() < m_options.nonMatchingRatio)
+        {
+            file_name = non_matching_names.at(i % non_matching_names.count()).arg(i);
+        }
+        else
+        {
+            // Collisions reuse the timestamp of an earlier file.
+            if (!used_timestamps.isEmpty() && CorpusGenerator::randomRatio() < m_options.collisionRatio)
+            {
+                file_timestamp = used_timestamps.at(qrand() % used_timestamps.count());
+            }
+            else
+            {
+                timestamp = timestamp.addSecs(120);
+                file_timestamp = timestamp;
+                used_timestamps.append(file_timestamp);
+            }
+
+            QString suffix = image_suffixes.at(qrand() % image_suffixes.count());
+            file_name = this->uniqueFileName(i % m_FILTER_COUNT, file_timestamp, suffix);
+            if (suffix.compare("png", Qt::CaseInsensitive) == 0)
+            {
+                file_data = TestImage::png();
+            }
+            else if (suffix.compare("gif", Qt::CaseInsensitive) == 0)
+            {
+                file_data = TestImage::gif();
+            }
+            else if (suffix.compare("bmp", Qt::CaseInsensitive) == 0)
+            {
+                file_data = TestImage::bmp();
+            }
+            else if (CorpusGenerator::randomRatio() < m_options.exifRatio)
+            {
+                file_data = TestImage::jpeg(file_timestamp.toString("yyyy:MM:dd HH:mm:ss"));
+            }
+            else
+            {
+                file_data = TestImage::jpeg();
+            }
+        }
+
+        QString file_path = directory.filePath(file_name);
+        QFile file(file_path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(file_data) != file_data.size())
+        {
+            return -1;
+        }
+        file.close();
+
+        // Files without DateTimeOriginal are named after their modification time.
+        CorpusGenerator::setModificationTime(file_path, file_timestamp);
+
+        created_file_count++;
+    }
+
+    return created_file_count;
+}
+
+QString CorpusGenerator::uniqueFileName(int filterIndex, const QDateTime &timestamp, const QString &suffix)
+{
+    // Names derived from the timestamp can repeat on collisions, move to a random-named filter then.
+    QString file_name = this->fileName(filterIndex, timestamp, suffix);
+    for (int i = 1; m_fileNames.contains(file_name); i++)
+    {
+        file_name = this->fileName((filterIndex + i) % m_FILTER_COUNT, timestamp, suffix);
+    }
+    m_fileNames.insert(file_name);
+
+    return file_name;
+}
+
+QString CorpusGenerator::fileName(int filterIndex, const QDateTime &timestamp, const QString &suffix) const
+{
+    QString file_name;
+    switch (filterIndex)
+    {
+    case 0:
+        // Tumblr 1.
+        file_name = "https%3A%2F%2F66.media.tumblr.com%2Ftumblr_" + CorpusGenerator::randomString(ALPHANUMERICS, 19) + "_1280";
+        break;
+    case 1:
+        // Tumblr 2.
+        file_name = "tumblr_" + CorpusGenerator::randomString(ALPHANUMERICS, 19) + "_1280";
+        break;
+    case 2:
+        // Tumblr 3.
+        file_name = "tumblr_" + CorpusGenerator::randomString(ALPHANUMERICS, 20) + "_r1_500";
+        break;
+    case 3:
+    case 9:
+        // Tumblr 4 and Google Images.
+        file_name = CorpusGenerator::randomUuid();
+        break;
+    case 4:
+        // Phonegram.
+        file_name = timestamp.toString("'IMG_'yyyyMMdd_HHmmss_") + CorpusGenerator::randomString(DIGITS, 3);
+        break;
+    case 5:
+        // Telegram.
+        file_name = CorpusGenerator::randomString(DIGITS, 9) + "_" + CorpusGenerator::randomString(DIGITS, 6);
+        break;
+    case 6:
+        // Runkeeper app: epoch in milliseconds.
+        file_name = QString::number(timestamp.toMSecsSinceEpoch()).rightJustified(13, '0');
+        break;
+    case 7:
+        // Runkeeper web.
+        file_name = CorpusGenerator::randomString(ALPHANUMERICS, 24);
+        break;
+    case 8:
+        // Flipboard.
+        file_name = CorpusGenerator::randomString(HEX_DIGITS, 40);
+        break;
+    case 10:
+    default:
+        // Android.
+        file_name = timestamp.toString("'IMG_'yyyyMMdd_HHmmss");
+        break;
+    }
+
+    return file_name + "." + suffix;
+}
+
+QString CorpusGenerator::randomString(const char *alphabet, int length)
+{
+    int alphabet_length = qstrlen(alphabet);
+    QString random_string;
+    random_string.reserve(length);
+    for (int i = 0; i < length; i++)
+    {
+        random_string += QLatin1Char(alphabet[qrand() % alphabet_length]);
+    }
+
+    return random_string;
+}
+
+QString CorpusGenerator::randomUuid()
+{
+    return CorpusGenerator::randomString(HEX_DIGITS, 8) + "-" + CorpusGenerator::randomString(HEX_DIGITS, 4) + "-" +
+           CorpusGenerator::randomString(HEX_DIGITS, 4) + "-" + CorpusGenerator::randomString(HEX_DIGITS, 4) + "-" +
+           CorpusGenerator::randomString(HEX_DIGITS, 12);
+}
+
+double CorpusGenerator::randomRatio()
+{
+    return static_cast<double>(qrand()) / (static_cast<double>(RAND_MAX) + 1.0);
+}
+
+bool CorpusGenerator::setModificationTime(const QString &filePath, const QDateTime &timestamp)
+{
+#ifdef Q_OS_WIN
+    struct _utimbuf times;
+    times.actime = timestamp.toTime_t();
+    times.modtime = timestamp.toTime_t();
+
+    return _wutime(reinterpret_cast<const wchar_t *>(filePath.utf16()), &times) == 0;
+#else
+    struct utimbuf times;
+    times.actime = timestamp.toTime_t();
+    times.modtime = timestamp.toTime_t();
+
+    return utime(QFile::encodeName(filePath).constData(), &times) == 0;
+#endif
+}
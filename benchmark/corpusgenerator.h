@@ -0,0 +1,48 @@
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+// Qt
+#include <QDateTime>
+#include <QDir>
+#include <QSet>
+#include <QStringList>
+
+// Fills a directory with synthetic files named after every built-in filter pattern.
+// JPEG files carry DateTimeOriginal or not, PNG, GIF and BMP files fall back to the file time,
+// and a share of the files reuses the timestamp of an earlier one to create name collisions.
+class CorpusGenerator
+{
+public:
+    struct Options
+    {
+        int fileCount;
+        double exifRatio;
+        double collisionRatio;
+        double nonMatchingRatio;
+        uint seed;
+    };
+
+private:
+    static const int m_FILTER_COUNT;
+    Options m_options;
+    QSet<QString> m_fileNames;
+
+public:
+    explicit CorpusGenerator(const Options &options);
+
+public:
+    static Options defaultOptions();
+    static bool parseOptions(const QStringList &arguments, Options &options, QStringList &remainingArguments);
+    static QString usage();
+    int generate(const QDir &directory);
+
+private:
+    QString uniqueFileName(int filterIndex, const QDateTime &timestamp, const QString &suffix);
+    QString fileName(int filterIndex, const QDateTime &timestamp, const QString &suffix) const;
+    static QString randomString(const char *alphabet, int length);
+    static QString randomUuid();
+    static double randomRatio();
+    static bool setModificationTime(const QString &filePath, const QDateTime &timestamp);
+};
+
+#endif // CORPUSGENERATOR_H
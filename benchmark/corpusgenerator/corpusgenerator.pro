@@ -0,0 +1,34 @@
+TARGET = MONSTER_fr_corpus
+
+TEMPLATE = app
+
+QT += \
+    core
+QT -= \
+    gui
+
+CONFIG += \
+    c++11 \
+    console
+
+CONFIG(debug, debug|release) {
+    DESTDIR = $${OUT_PWD}/debug
+}
+CONFIG(release, debug|release) {
+    DESTDIR = $${OUT_PWD}/release
+}
+MOC_DIR = $${DESTDIR}/.moc
+OBJECTS_DIR = $${DESTDIR}/.obj
+RCC_DIR = $${DESTDIR}/.rcc
+
+INCLUDEPATH += \
+    "$$PWD/.."
+
+HEADERS += \
+    ../corpusgenerator.h \
+    ../testimage.h
+
+SOURCES += \
+    ../corpusgenerator.cpp \
+    ../testimage.cpp \
+    main.cpp
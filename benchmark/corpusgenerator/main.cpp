@@ -0,0 +1,58 @@
+// Qt
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Local
+#include "corpusgenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    // Usage: MONSTER_fr_corpus [options] [directory]
+    QStringList arguments = application.arguments();
+    CorpusGenerator::Options options = CorpusGenerator::defaultOptions();
+    QStringList remaining_arguments;
+    if (!CorpusGenerator::parseOptions(arguments.mid(1), options, remaining_arguments) || remaining_arguments.count() > 1)
+    {
+        QTextStream(stderr) << "Usage: " << arguments.value(0) << " " << CorpusGenerator::usage() << " [directory]" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // Without a directory, generate into a new temporary directory that is left in place.
+    QString directory_path = remaining_arguments.value(0);
+    if (directory_path.isEmpty())
+    {
+        QTemporaryDir temporary_dir;
+        if (!temporary_dir.isValid())
+        {
+            QTextStream(stderr) << "Cannot create a temporary directory" << endl;
+
+            return EXIT_FAILURE;
+        }
+        temporary_dir.setAutoRemove(false);
+        directory_path = temporary_dir.path();
+    }
+    QDir directory(directory_path);
+    if (!directory.mkpath("."))
+    {
+        QTextStream(stderr) << "Cannot create " << directory_path << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    CorpusGenerator corpus_generator(options);
+    int file_count = corpus_generator.generate(directory);
+    if (file_count < 0)
+    {
+        QTextStream(stderr) << "Cannot write the corpus to " << directory.absolutePath() << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    QTextStream(stdout) << file_count << " files created in " << directory.absolutePath() << endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+// Qt
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// Exiv2
+#include <exiv2/exiv2.hpp>
+
+// Local
+#include "exifreaderbenchmark.h"
+#include "exifreader.h"
+#include "windowedfileio.h"
+
+namespace
+{
+    // File I/O that counts the bytes Exiv2 pulls from the file.
+    class CountingFileIo : public Exiv2::FileIo
+    {
+    private:
+        qint64 &m_bytesRead;
+
+    public:
+        CountingFileIo(const std::string &path, qint64 &bytesRead) :
+            Exiv2::FileIo(path),
+            m_bytesRead(bytesRead)
+        {
+        }
+
+    public:
+        virtual Exiv2::DataBuf read(long rcount)
+        {
+            Exiv2::DataBuf data_buf = Exiv2::FileIo::read(rcount);
+            m_bytesRead += data_buf.size_;
+
+            return data_buf;
+        }
+
+        virtual long read(Exiv2::byte *buf, long rcount)
+        {
+            long read_count = Exiv2::FileIo::read(buf, rcount);
+            m_bytesRead += read_count;
+
+            return read_count;
+        }
+
+        virtual int getb()
+        {
+            int read_byte = Exiv2::FileIo::getb();
+            if (read_byte != EOF)
+            {
+                m_bytesRead++;
+            }
+
+            return read_byte;
+        }
+
+        virtual Exiv2::byte *mmap(bool isWriteable = false)
+        {
+            // A mapping may be paged in entirely, count it as a full read.
+            m_bytesRead += this->size();
+
+            return Exiv2::FileIo::mmap(isWriteable);
+        }
+    };
+}
+
+int ExifReaderBenchmark::run(const QStringList &arguments)
+{
+    QTextStream output(stdout);
+    if (arguments.isEmpty())
+    {
+        QTextStream(stderr) << "Missing image directory" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    QDir directory(arguments.at(0));
+    QStringList name_filters;
+    name_filters << "*.jpg" << "*.jpeg" << "*.JPG" << "*.JPEG";
+    QFileInfoList files = directory.entryInfoList(name_filters, QDir::Files, QDir::Name);
+    if (files.isEmpty())
+    {
+        QTextStream(stderr) << "No JPEG files in " << directory.absolutePath() << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    qint64 fast_bytes_read = 0;
+    qint64 fast_elapsed_ns = 0;
+    qint64 exiv2_bytes_read = 0;
+    qint64 exiv2_elapsed_ns = 0;
+    qint64 windowed_bytes_read = 0;
+    qint64 windowed_elapsed_ns = 0;
+    int fallback_count = 0;
+    int mismatch_count = 0;
+    QElapsedTimer elapsed_timer;
+
+    foreach (const QFileInfo &file, files)
+    {
+        QString file_path = file.absoluteFilePath();
+
+        QString fast_date_time_original;
+        qint64 bytes_read = 0;
+        elapsed_timer.start();
+        ExifReader::ExifRead_RetVal ret_val = ExifReader::readJpegDateTimeOriginal(file_path, fast_date_time_original, &bytes_read);
+        fast_elapsed_ns += elapsed_timer.nsecsElapsed();
+        fast_bytes_read += bytes_read;
+
+        QString exiv2_date_time_original;
+        bytes_read = 0;
+        elapsed_timer.start();
+        bool exiv2_found = ExifReaderBenchmark::readExiv2DateTimeOriginal(file_path, false, exiv2_date_time_original, bytes_read);
+        exiv2_elapsed_ns += elapsed_timer.nsecsElapsed();
+        exiv2_bytes_read += bytes_read;
+
+        QString windowed_date_time_original;
+        bytes_read = 0;
+        elapsed_timer.start();
+        bool windowed_found = ExifReaderBenchmark::readExiv2DateTimeOriginal(file_path, true, windowed_date_time_original, bytes_read);
+        windowed_elapsed_ns += elapsed_timer.nsecsElapsed();
+        windowed_bytes_read += bytes_read;
+        if (windowed_found != exiv2_found || windowed_date_time_original != exiv2_date_time_original)
+        {
+            mismatch_count++;
+            output << "  windowed mismatch: " << file.fileName() << " (" << windowed_date_time_original << " / " << exiv2_date_time_original << ")" << endl;
+        }
+
+        if (ret_val == ExifReader::ExifRead_Unsupported)
+        {
+            fallback_count++;
+        }
+        else if ((ret_val == ExifReader::ExifRead_Found) != exiv2_found || fast_date_time_original != exiv2_date_time_original)
+        {
+            mismatch_count++;
+            output << "  mismatch: " << file.fileName() << " (" << fast_date_time_original << " / " << exiv2_date_time_original << ")" << endl;
+        }
+    }
+
+    int file_count = files.count();
+    output << "Exif reader benchmark: " << file_count << " files" << endl;
+    output << "  fast path: " << fast_bytes_read / file_count << " bytes/file, " << fast_elapsed_ns / 1000 / file_count << " us/file" << endl;
+    output << "  Exiv2:     " << exiv2_bytes_read / file_count << " bytes/file, " << exiv2_elapsed_ns / 1000 / file_count << " us/file" << endl;
+    output << "  windowed:  " << windowed_bytes_read / file_count << " bytes/file, " << windowed_elapsed_ns / 1000 / file_count << " us/file" << endl;
+    output << "  fallbacks: " << fallback_count << ", mismatches: " << mismatch_count << endl;
+
+    return mismatch_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool ExifReaderBenchmark::readExiv2DateTimeOriginal(const QString &filePath, bool windowed, QString &dateTimeOriginal, qint64 &bytesRead)
+{
+    try
+    {
+        WindowedFileIo *windowed_file_io = NULL;
+        Exiv2::BasicIo::AutoPtr io;
+        if (windowed)
+        {
+            windowed_file_io = new WindowedFileIo(filePath);
+            io.reset(windowed_file_io);
+        }
+        else
+        {
+            io.reset(new CountingFileIo(filePath.toStdString(), bytesRead));
+        }
+        Exiv2::Image::AutoPtr image = Exiv2::ImageFactory::open(io);
+        if (image.get() == NULL)
+        {
+            return false;
+        }
+
+        image->readMetadata();
+        if (windowed_file_io != NULL)
+        {
+            // Count a mapping as a full read, as for the plain file I/O.
+            bytesRead += windowed_file_io->bytesRead() + windowed_file_io->bytesMapped();
+        }
+        Exiv2::ExifData &exif_data = image->exifData();
+        Exiv2::ExifData::const_iterator pos = exif_data.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal"));
+        if (pos == exif_data.end())
+        {
+            return false;
+        }
+        dateTimeOriginal = QString::fromStdString(pos->toString());
+
+        return true;
+    }
+    catch (Exiv2::AnyError &)
+    {
+        return false;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef EXIFREADERBENCHMARK_H
+#define EXIFREADERBENCHMARK_H
+
+// Qt
+#include <QStringList>
+#include <QString>
+
+// Measures bytes read and time per file of the JPEG fast path against a full Exiv2 metadata read,
+// through the plain and the windowed file I/O.
+class ExifReaderBenchmark
+{
+public:
+    static int run(const QStringList &arguments);
+
+private:
+    static bool readExiv2DateTimeOriginal(const QString &filePath, bool windowed, QString &dateTimeOriginal, qint64 &bytesRead);
+};
+
+#endif // EXIFREADERBENCHMARK_H
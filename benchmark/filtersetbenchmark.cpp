@@ -0,0 +1,122 @@
+// Qt
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QTextStream>
+
+// Local
+#include "filtersetbenchmark.h"
+#include "filerenamer.h"
+
+int FilterSetBenchmark::run(const QStringList &arguments)
+{
+    int name_count = arguments.isEmpty() ? 100000 : arguments.at(0).toInt();
+    if (name_count <= 0)
+    {
+        name_count = 100000;
+    }
+
+    FileRenamer file_renamer;
+    const FilterSet &filter_set = file_renamer.fileFilters();
+    QStringList names = FilterSetBenchmark::sampleNames(name_count);
+
+    QTextStream output(stdout);
+    output << "Filter set benchmark: " << names.count() << " names, " << filter_set.count() << " filters" << endl;
+
+    QElapsedTimer elapsed_timer;
+
+    elapsed_timer.start();
+    int legacy_match_count = FilterSetBenchmark::matchLegacy(filter_set, names);
+    qint64 legacy_elapsed_ns = qMax<qint64>(elapsed_timer.nsecsElapsed(), 1);
+
+    elapsed_timer.start();
+    int compiled_match_count = FilterSetBenchmark::matchCompiled(filter_set, names);
+    qint64 compiled_elapsed_ns = qMax<qint64>(elapsed_timer.nsecsElapsed(), 1);
+
+    double legacy_names_per_second = names.count() * 1e9 / legacy_elapsed_ns;
+    double compiled_names_per_second = names.count() * 1e9 / compiled_elapsed_ns;
+    output << "  per-file regex loop: " << qRound64(legacy_names_per_second) << " names/s (" << legacy_match_count << " matches)" << endl;
+    output << "  compiled filter set: " << qRound64(compiled_names_per_second) << " names/s (" << compiled_match_count << " matches)" << endl;
+    output << "  speed-up: " << QString::number(compiled_names_per_second / legacy_names_per_second, 'f', 1) << "x" << endl;
+
+    // Both approaches must agree on what matches.
+    return legacy_match_count == compiled_match_count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+QStringList FilterSetBenchmark::sampleNames(int nameCount)
+{
+    // One matching sample per built-in filter, followed by names that match none of them.
+    static const char *const SAMPLE_NAMES[] =
+    {
+        "https%3A%2F%2F66.media.tumblr.com%2Ftumblr_abcdefghij012345678_1280.jpg",
+        "tumblr_abcdefghij012345678_1280.jpg",
+        "tumblr_abcdefghij0123456789_r1_500.png",
+        "0123abcd-0123-4567-89ab-0123456789ab.JPG",
+        "IMG_20170812_153012_123.jpg",
+        "123456789_123456.jpg",
+        "1502544612123.jpg",
+        "abcdefghijklmnopqrstuvwx.png",
+        "0123456789abcdef0123456789abcdef01234567.jpeg",
+        "0123abcd-0123-4567-89ab-0123456789ab.gif",
+        "IMG_20170812_153012.jpg",
+        "2017-08-12 15.30.12.jpg",
+        "holiday_at_the_sea.jpg",
+        "DSC_0042.NEF",
+        "notes.txt",
+        "IMG_2017.jpg",
+        "report_final_v2.pdf",
+        "Screenshot_20170812-153012.png",
+        "tumblr_short_1280.jpg",
+        "VID_20170812_153012.mp4",
+    };
+    const int sample_name_count = sizeof(SAMPLE_NAMES) / sizeof(SAMPLE_NAMES[0]);
+
+    QStringList names;
+    names.reserve(nameCount);
+    for (int i = 0; i < nameCount; i++)
+    {
+        names.append(QString(SAMPLE_NAMES[i % sample_name_count]));
+    }
+
+    return names;
+}
+
+int FilterSetBenchmark::matchLegacy(const FilterSet &filterSet, const QStringList &names)
+{
+    // Reproduces the original loop: one expression built per filter and per name, no early exit.
+    int match_count = 0;
+    foreach (const QString &name, names)
+    {
+        bool file_filter_match = false;
+        for (int i = 0; i < filterSet.count(); i++)
+        {
+            QRegularExpression regular_expression(filterSet.filterPattern(i));
+            QRegularExpressionMatch regular_expression_match = regular_expression.match(name);
+            if (regular_expression_match.hasMatch())
+            {
+                file_filter_match = true;
+
+                continue;
+            }
+        }
+        if (file_filter_match)
+        {
+            match_count++;
+        }
+    }
+
+    return match_count;
+}
+
+int FilterSetBenchmark::matchCompiled(const FilterSet &filterSet, const QStringList &names)
+{
+    int match_count = 0;
+    foreach (const QString &name, names)
+    {
+        if (filterSet.match(name) != FilterSet::NO_MATCH)
+        {
+            match_count++;
+        }
+    }
+
+    return match_count;
+}
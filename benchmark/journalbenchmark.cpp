@@ -0,0 +1,106 @@
+// Qt
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Local
+#include "journalbenchmark.h"
+#include "filerenamer.h"
+#include "testimage.h"
+
+int JournalBenchmark::run(const QStringList &arguments)
+{
+    int file_count = arguments.isEmpty() ? 2000 : arguments.at(0).toInt();
+    if (file_count <= 0)
+    {
+        file_count = 2000;
+    }
+
+    QTextStream output(stdout);
+    output << "Journal benchmark: " << file_count << " files" << endl;
+
+    // Group size 0 means no journal.
+    QList<int> journal_group_sizes;
+    journal_group_sizes << 0 << RenameJournal::DEFAULT_GROUP_SIZE << 1;
+
+    qint64 baseline_elapsed_ns = 0;
+    foreach (int journal_group_size, journal_group_sizes)
+    {
+        int renamed_file_count = 0;
+        int sync_count = 0;
+        qint64 elapsed_ns = JournalBenchmark::renameFiles(file_count, journal_group_size, renamed_file_count, sync_count);
+        if (elapsed_ns < 0)
+        {
+            QTextStream(stderr) << "Cannot create the test files" << endl;
+
+            return EXIT_FAILURE;
+        }
+        if (renamed_file_count != file_count)
+        {
+            QTextStream(stderr) << "Only " << renamed_file_count << "/" << file_count << " files renamed" << endl;
+
+            return EXIT_FAILURE;
+        }
+
+        QString label = journal_group_size == 0 ? QString("no journal") : "journal, group of " + QString::number(journal_group_size);
+        output << "  " << label.leftJustified(20) << ": " << qRound64(file_count * 1e9 / qMax<qint64>(elapsed_ns, 1)) << " files/s, " << sync_count << " syncs";
+        if (journal_group_size == 0)
+        {
+            baseline_elapsed_ns = elapsed_ns;
+        }
+        else
+        {
+            output << ", overhead " << QString::number(100.0 * (elapsed_ns - baseline_elapsed_ns) / qMax<qint64>(baseline_elapsed_ns, 1), 'f', 1) << "%";
+        }
+        output << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+qint64 JournalBenchmark::renameFiles(int fileCount, int journalGroupSize, int &renamedFileCount, int &syncCount)
+{
+    QTemporaryDir temporary_dir;
+    if (!temporary_dir.isValid())
+    {
+        return -1;
+    }
+
+    // Android style names, each with its own timestamp so that no collision gets in the way.
+    QDir directory(temporary_dir.path());
+    QDateTime timestamp(QDate(2017, 1, 1), QTime(0, 0, 0));
+    for (int i = 0; i < fileCount; i++, timestamp = timestamp.addSecs(1))
+    {
+        QFile file(directory.filePath(timestamp.toString("'IMG_'yyyyMMdd_HHmmss'.jpg'")));
+        if (!file.open(QIODevice::WriteOnly) || file.write(TestImage::jpeg(timestamp.toString("yyyy:MM:dd HH:mm:ss"))) < 0)
+        {
+            return -1;
+        }
+    }
+
+    FileRenamer file_renamer;
+    QString journal_file_path = QDir(temporary_dir.path()).filePath("journal.jsonl");
+    if (journalGroupSize > 0)
+    {
+        file_renamer.setJournalGroupSize(journalGroupSize);
+        file_renamer.openJournal(journal_file_path, false);
+    }
+
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+
+    QList<QDir> directories;
+    directories.append(directory);
+    file_renamer.processDirectories(directories);
+    file_renamer.closeJournal();
+
+    qint64 elapsed_ns = elapsed_timer.nsecsElapsed();
+
+    renamedFileCount = file_renamer.renamedFileCount();
+    syncCount = file_renamer.journalSyncCount();
+
+    return elapsed_ns;
+}
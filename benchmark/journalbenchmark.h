@@ -0,0 +1,18 @@
+#ifndef JOURNALBENCHMARK_H
+#define JOURNALBENCHMARK_H
+
+// Qt
+#include <QStringList>
+
+// Measures the cost of the rename journal: the same set of renames without a journal,
+// with group commit and with one fsync per file.
+class JournalBenchmark
+{
+public:
+    static int run(const QStringList &arguments);
+
+private:
+    static qint64 renameFiles(int fileCount, int journalGroupSize, int &renamedFileCount, int &syncCount);
+};
+
+#endif // JOURNALBENCHMARK_H
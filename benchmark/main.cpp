@@ -0,0 +1,82 @@
+// Qt
+#include <QCoreApplication>
+#include <QMutex>
+#include <QTextStream>
+
+// Exiv2
+#include <exiv2/exiv2.hpp>
+
+// Local
+#include "corpusgenerator.h"
+#include "exifreaderbenchmark.h"
+#include "filtersetbenchmark.h"
+#include "journalbenchmark.h"
+#include "logmanager.h"
+#include "renamerbenchmark.h"
+#include "rulesbenchmark.h"
+
+static QMutex xmp_mutex;
+
+static void xmpLockUnlock(void *lockData, bool lockUnlock)
+{
+    QMutex *mutex = static_cast<QMutex *>(lockData);
+    if (lockUnlock)
+    {
+        mutex->lock();
+    }
+    else
+    {
+        mutex->unlock();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    // Keep the renamer quiet, only the measurements are printed.
+    LogManager::setLogLevel(LogManager::LogLevel_None);
+
+    // The renamer benchmark may use several threads: set up the XMP toolkit with a lock before any
+    // of them starts, the same way the application does.
+    if (!Exiv2::XmpParser::initialize(xmpLockUnlock, &xmp_mutex))
+    {
+        QTextStream(stderr) << "Cannot initialize the XMP toolkit" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // Usage: MONSTER_fr_benchmark <benchmark> [arguments...]
+    QStringList arguments = application.arguments();
+    QString benchmark = arguments.value(1);
+    QStringList benchmark_arguments = arguments.mid(2);
+
+    if (benchmark == "filters")
+    {
+        return FilterSetBenchmark::run(benchmark_arguments);
+    }
+    if (benchmark == "exif")
+    {
+        return ExifReaderBenchmark::run(benchmark_arguments);
+    }
+    if (benchmark == "journal")
+    {
+        return JournalBenchmark::run(benchmark_arguments);
+    }
+    if (benchmark == "renamer")
+    {
+        return RenamerBenchmark::run(benchmark_arguments);
+    }
+    if (benchmark == "rules")
+    {
+        return RulesBenchmark::run(benchmark_arguments);
+    }
+
+    QTextStream(stderr) << "Usage: " << arguments.value(0) << " filters [name count]" << endl
+                        << "       " << arguments.value(0) << " exif <jpeg directory>" << endl
+                        << "       " << arguments.value(0) << " journal [file count]" << endl
+                        << "       " << arguments.value(0) << " renamer " << CorpusGenerator::usage() << " [--jobs N]" << endl
+                        << "       " << arguments.value(0) << " rules [rule count] [budget ms]" << endl;
+
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,140 @@
+// Std
+#include <algorithm>
+
+// Qt
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#if defined(Q_OS_WIN)
+// Windows
+#include <windows.h>
+#include <psapi.h>
+#elif !defined(Q_OS_LINUX)
+// Posix
+#include <sys/resource.h>
+#endif
+
+// Local
+#include "renamerbenchmark.h"
+#include "corpusgenerator.h"
+#include "filerenamer.h"
+
+int RenamerBenchmark::run(const QStringList &arguments)
+{
+    CorpusGenerator::Options options = CorpusGenerator::defaultOptions();
+    QStringList remaining_arguments;
+    int job_count = 1;
+    bool options_valid = CorpusGenerator::parseOptions(arguments, options, remaining_arguments);
+    for (int i = 0; options_valid && i < remaining_arguments.count(); i++)
+    {
+        if (remaining_arguments.at(i) == "--jobs")
+        {
+            job_count = remaining_arguments.value(++i).toInt(&options_valid);
+        }
+        else
+        {
+            options_valid = false;
+        }
+    }
+    if (!options_valid)
+    {
+        QTextStream(stderr) << "Invalid renamer benchmark options" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // Every run needs a fresh corpus, the renamer consumes it.
+    QTemporaryDir temporary_dir;
+    if (!temporary_dir.isValid())
+    {
+        QTextStream(stderr) << "Cannot create a temporary directory" << endl;
+
+        return EXIT_FAILURE;
+    }
+    QDir directory(temporary_dir.path());
+    CorpusGenerator corpus_generator(options);
+    int file_count = corpus_generator.generate(directory);
+    if (file_count < 0)
+    {
+        QTextStream(stderr) << "Cannot write the corpus" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    FileRenamer file_renamer;
+    file_renamer.setJobCount(job_count);
+    file_renamer.setFileLatencyRecording(true);
+
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+
+    QList<QDir> directories;
+    directories.append(directory);
+    file_renamer.processDirectories(directories);
+
+    qint64 elapsed_ns = qMax<qint64>(elapsed_timer.nsecsElapsed(), 1);
+
+    const QVector<qint64> &file_latencies = file_renamer.fileLatencies();
+    QTextStream output(stdout);
+    output << "Renamer benchmark: " << file_count << " files, " << job_count << " jobs, "
+           << "exif " << options.exifRatio << ", collisions " << options.collisionRatio << ", non-matching " << options.nonMatchingRatio << endl;
+    output << "  renamed:    " << file_renamer.renamedFileCount() << "/" << file_renamer.totalFileCount() << endl;
+    output << "  throughput: " << qRound64(file_count * 1e9 / elapsed_ns) << " files/s" << endl;
+    output << "  latency:    p50 " << RenamerBenchmark::percentile(file_latencies, 0.50) / 1000 << " us, p99 " << RenamerBenchmark::percentile(file_latencies, 0.99) / 1000 << " us" << endl;
+    output << "  peak RSS:   " << RenamerBenchmark::peakResidentSetSize() / 1024 << " KiB" << endl;
+
+    return file_renamer.renamedFileCount() == file_renamer.totalFileCount() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+qint64 RenamerBenchmark::percentile(QVector<qint64> values, double ratio)
+{
+    if (values.isEmpty())
+    {
+        return 0;
+    }
+
+    int index = qMin(static_cast<int>(values.count() * ratio), values.count() - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+
+    return values.at(index);
+}
+
+qint64 RenamerBenchmark::peakResidentSetSize()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS process_memory_counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &process_memory_counters, sizeof(process_memory_counters)))
+    {
+        return 0;
+    }
+
+    return process_memory_counters.PeakWorkingSetSize;
+#elif defined(Q_OS_LINUX)
+    QFile status_file("/proc/self/status");
+    if (!status_file.open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+    while (!status_file.atEnd())
+    {
+        QByteArray line = status_file.readLine();
+        if (line.startsWith("VmHWM:"))
+        {
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024;
+        }
+    }
+
+    return 0;
+#else
+    struct rusage resource_usage;
+    if (getrusage(RUSAGE_SELF, &resource_usage) != 0)
+    {
+        return 0;
+    }
+
+    // Bytes on macOS.
+    return resource_usage.ru_maxrss;
+#endif
+}
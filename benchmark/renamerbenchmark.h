@@ -0,0 +1,20 @@
+#ifndef RENAMERBENCHMARK_H
+#define RENAMERBENCHMARK_H
+
+// Qt
+#include <QStringList>
+#include <QVector>
+
+// Drives FileRenamer::processDirectories over a generated corpus and reports
+// files per second, p50/p99 per-file latency and the peak resident set size.
+class RenamerBenchmark
+{
+public:
+    static int run(const QStringList &arguments);
+
+private:
+    static qint64 percentile(QVector<qint64> values, double ratio);
+    static qint64 peakResidentSetSize();
+};
+
+#endif // RENAMERBENCHMARK_H
@@ -0,0 +1,148 @@
+// Qt
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Local
+#include "rulesbenchmark.h"
+#include "filterrules.h"
+
+int RulesBenchmark::run(const QStringList &arguments)
+{
+    int rule_count = arguments.value(0).toInt();
+    if (rule_count <= 0)
+    {
+        rule_count = 500;
+    }
+    double budget_ms = arguments.value(1).toDouble();
+    if (budget_ms <= 0.0)
+    {
+        budget_ms = 50.0;
+    }
+
+    QTemporaryDir temporary_dir;
+    QString rules_file_path = temporary_dir.path() + "/rules.jsonl";
+    if (!temporary_dir.isValid() || !RulesBenchmark::writeRules(rules_file_path, rule_count))
+    {
+        QTextStream(stderr) << "Cannot create the rules file" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    QTextStream output(stdout);
+    output << "Rules benchmark: " << rule_count << " rules, budget " << budget_ms << " ms" << endl;
+
+    // The first load finds no compiled form and leaves one behind for the second.
+    FilterSet compiled_filter_set;
+    bool compiled_cache_used = false;
+    qint64 compiled_elapsed_ns = RulesBenchmark::loadRules(rules_file_path, compiled_filter_set, compiled_cache_used);
+    FilterSet cached_filter_set;
+    bool cached_cache_used = false;
+    qint64 cached_elapsed_ns = RulesBenchmark::loadRules(rules_file_path, cached_filter_set, cached_cache_used);
+    if (compiled_elapsed_ns < 0 || cached_elapsed_ns < 0)
+    {
+        QTextStream(stderr) << "Cannot load the rules file" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    double compiled_elapsed_ms = compiled_elapsed_ns / 1e6;
+    double cached_elapsed_ms = cached_elapsed_ns / 1e6;
+    output << "  compiled: " << QString::number(compiled_elapsed_ms, 'f', 2) << " ms" << endl;
+    output << "  cached  : " << QString::number(cached_elapsed_ms, 'f', 2) << " ms" << (cached_cache_used ? "" : " (cache not used)") << endl;
+
+    if (compiled_cache_used || !cached_cache_used)
+    {
+        QTextStream(stderr) << "The compiled form was not cached" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (!RulesBenchmark::matchesAgree(compiled_filter_set, cached_filter_set, rule_count))
+    {
+        QTextStream(stderr) << "The cached rules don't match like the compiled ones" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (cached_elapsed_ms > budget_ms)
+    {
+        QTextStream(stderr) << "Start-up over budget: " << cached_elapsed_ms << " ms" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+bool RulesBenchmark::writeRules(const QString &rulesFilePath, int ruleCount)
+{
+    QFile rules_file(rulesFilePath);
+    if (!rules_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    // Rules shaped like the built-in filters, each with its own literal prefix.
+    for (int i = 0; i < ruleCount; i++)
+    {
+        FilterRules::Rule rule;
+        rule.name = "Rule " + QString::number(i);
+        switch (i % 3)
+        {
+        case 0:
+            rule.pattern = QString("^app%1_[0-9]{8}_[0-9]{6}\\.(?i)(jpe?g|png)$").arg(i);
+            rule.decoder = NameTimestampDecoder::Decoder_DateTime;
+            break;
+        case 1:
+            rule.pattern = QString("^app%1_[0-9]{13}\\.(?i)(jpe?g|png)$").arg(i);
+            rule.decoder = NameTimestampDecoder::Decoder_EpochMilliseconds;
+            break;
+        default:
+            rule.pattern = QString("^app%1_[0-9a-zA-Z]{16,24}\\.(?i)(jpe?g|png|gif)$").arg(i);
+            rule.decoder = NameTimestampDecoder::Decoder_None;
+            break;
+        }
+
+        QByteArray line = FilterRules::formatRule(rule);
+        line += '\n';
+        if (rules_file.write(line) != line.size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+qint64 RulesBenchmark::loadRules(const QString &rulesFilePath, FilterSet &filterSet, bool &cacheUsed)
+{
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+    if (!FilterRules::load(rulesFilePath, filterSet, NULL, &cacheUsed))
+    {
+        return -1;
+    }
+
+    return elapsed_timer.nsecsElapsed();
+}
+
+bool RulesBenchmark::matchesAgree(const FilterSet &compiledFilterSet, const FilterSet &cachedFilterSet, int ruleCount)
+{
+    for (int i = 0; i < ruleCount; i++)
+    {
+        QStringList names;
+        names << QString("app%1_20170812_153012.jpg").arg(i)
+              << QString("app%1_1502544612123.png").arg(i)
+              << QString("app%1_abcdefghijklmnopqrst.gif").arg(i)
+              << QString("app%1_notes.txt").arg(i);
+        foreach (const QString &name, names)
+        {
+            if (compiledFilterSet.match(name) != cachedFilterSet.match(name))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
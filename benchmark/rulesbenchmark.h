@@ -0,0 +1,23 @@
+#ifndef RULESBENCHMARK_H
+#define RULESBENCHMARK_H
+
+// Qt
+#include <QStringList>
+
+// Local
+#include "filterset.h"
+
+// Measures the start-up cost of a filter rules file: loading and compiling the rules,
+// then loading them again from the compiled form kept next to the file, against a time budget.
+class RulesBenchmark
+{
+public:
+    static int run(const QStringList &arguments);
+
+private:
+    static bool writeRules(const QString &rulesFilePath, int ruleCount);
+    static qint64 loadRules(const QString &rulesFilePath, FilterSet &filterSet, bool &cacheUsed);
+    static bool matchesAgree(const FilterSet &compiledFilterSet, const FilterSet &cachedFilterSet, int ruleCount);
+};
+
+#endif // RULESBENCHMARK_H
@@ -0,0 +1,142 @@
+// Local
+#include "testimage.h"
+
+namespace
+{
+    void appendUInt16(QByteArray &data, quint16 value)
+    {
+        data += static_cast<char>(value & 0xFF);
+        data += static_cast<char>(value >> 8);
+    }
+
+    void appendUInt32(QByteArray &data, quint32 value)
+    {
+        appendUInt16(data, static_cast<quint16>(value & 0xFFFF));
+        appendUInt16(data, static_cast<quint16>(value >> 16));
+    }
+
+    void appendUInt32BigEndian(QByteArray &data, quint32 value)
+    {
+        data += static_cast<char>(value >> 24);
+        data += static_cast<char>((value >> 16) & 0xFF);
+        data += static_cast<char>((value >> 8) & 0xFF);
+        data += static_cast<char>(value & 0xFF);
+    }
+}
+
+QByteArray TestImage::jpeg(const QString &dateTimeOriginal)
+{
+    // Start of image.
+    QByteArray jpeg("\xFF\xD8", 2);
+
+    if (!dateTimeOriginal.isEmpty())
+    {
+        // Little-endian TIFF block: IFD0 with the Exif IFD pointer, Exif IFD with DateTimeOriginal.
+        QByteArray tiff("II*\0", 4);
+        appendUInt32(tiff, 8);
+
+        // IFD0 at 8.
+        appendUInt16(tiff, 1);
+        appendUInt16(tiff, 0x8769);
+        appendUInt16(tiff, 4);
+        appendUInt32(tiff, 1);
+        appendUInt32(tiff, 26);
+        appendUInt32(tiff, 0);
+
+        // Exif IFD at 26.
+        appendUInt16(tiff, 1);
+        appendUInt16(tiff, 0x9003);
+        appendUInt16(tiff, 2);
+        appendUInt32(tiff, 20);
+        appendUInt32(tiff, 44);
+        appendUInt32(tiff, 0);
+
+        // DateTimeOriginal value at 44: "YYYY:MM:DD HH:MM:SS" and a NUL.
+        tiff += dateTimeOriginal.toLatin1().left(19).leftJustified(19, ' ');
+        tiff += '\0';
+
+        // APP1 segment, big-endian length including itself.
+        quint16 segment_length = static_cast<quint16>(2 + 6 + tiff.size());
+        jpeg += "\xFF\xE1";
+        jpeg += static_cast<char>(segment_length >> 8);
+        jpeg += static_cast<char>(segment_length & 0xFF);
+        jpeg += QByteArray("Exif\0\0", 6);
+        jpeg += tiff;
+    }
+
+    // End of image.
+    jpeg += "\xFF\xD9";
+
+    return jpeg;
+}
+
+QByteArray TestImage::png()
+{
+    // Signature, a 1x1 greyscale IHDR and IEND; PNG cannot carry DateTimeOriginal.
+    QByteArray png("\x89PNG\r\n\x1A\n", 8);
+
+    QByteArray ihdr("IHDR", 4);
+    appendUInt32BigEndian(ihdr, 1);
+    appendUInt32BigEndian(ihdr, 1);
+    ihdr += QByteArray("\x08\x00\x00\x00\x00", 5);
+    appendUInt32BigEndian(png, 13);
+    png += ihdr;
+    appendUInt32BigEndian(png, TestImage::crc32(ihdr));
+
+    QByteArray iend("IEND", 4);
+    appendUInt32BigEndian(png, 0);
+    png += iend;
+    appendUInt32BigEndian(png, TestImage::crc32(iend));
+
+    return png;
+}
+
+QByteArray TestImage::gif()
+{
+    // Header, 1x1 logical screen without a colour table, trailer.
+    QByteArray gif("GIF89a", 6);
+    appendUInt16(gif, 1);
+    appendUInt16(gif, 1);
+    gif += QByteArray("\x00\x00\x00", 3);
+    gif += '\x3B';
+
+    return gif;
+}
+
+QByteArray TestImage::bmp()
+{
+    // File header, BITMAPINFOHEADER and one padded 24-bit pixel.
+    QByteArray bmp("BM", 2);
+    appendUInt32(bmp, 14 + 40 + 4);
+    appendUInt32(bmp, 0);
+    appendUInt32(bmp, 14 + 40);
+    appendUInt32(bmp, 40);
+    appendUInt32(bmp, 1);
+    appendUInt32(bmp, 1);
+    appendUInt16(bmp, 1);
+    appendUInt16(bmp, 24);
+    appendUInt32(bmp, 0);
+    appendUInt32(bmp, 4);
+    appendUInt32(bmp, 2835);
+    appendUInt32(bmp, 2835);
+    appendUInt32(bmp, 0);
+    appendUInt32(bmp, 0);
+    bmp += QByteArray(4, '\0');
+
+    return bmp;
+}
+
+quint32 TestImage::crc32(const QByteArray &data)
+{
+    quint32 crc = 0xFFFFFFFF;
+    for (int i = 0; i < data.size(); i++)
+    {
+        crc ^= static_cast<uchar>(data.at(i));
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+
+    return ~crc;
+}
@@ -0,0 +1,21 @@
+#ifndef TESTIMAGE_H
+#define TESTIMAGE_H
+
+// Qt
+#include <QByteArray>
+#include <QString>
+
+// Builds the smallest files the renamer will treat as images.
+class TestImage
+{
+public:
+    static QByteArray jpeg(const QString &dateTimeOriginal = QString());
+    static QByteArray png();
+    static QByteArray gif();
+    static QByteArray bmp();
+
+private:
+    static quint32 crc32(const QByteArray &data);
+};
+
+#endif // TESTIMAGE_H
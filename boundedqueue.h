@@ -0,0 +1,144 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+// Std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov's array-based design).
+// Each cell carries a sequence number telling producers and consumers whose turn it is,
+// so neither side ever takes a lock. The capacity is rounded up to a power of two.
+template <typename T>
+class BoundedQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    Cell *m_buffer;
+    size_t m_bufferMask;
+    std::atomic<size_t> m_enqueuePosition;
+    std::atomic<size_t> m_dequeuePosition;
+
+public:
+    explicit BoundedQueue(size_t capacity);
+    ~BoundedQueue();
+
+private:
+    BoundedQueue(const BoundedQueue &);
+    BoundedQueue &operator=(const BoundedQueue &);
+
+public:
+    size_t capacity() const;
+    bool tryEnqueue(const T &data);
+    bool tryDequeue(T &data);
+};
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity) :
+    m_buffer(NULL),
+    m_bufferMask(0),
+    m_enqueuePosition(0),
+    m_dequeuePosition(0)
+{
+    size_t buffer_size = 2;
+    while (buffer_size < capacity)
+    {
+        buffer_size <<= 1;
+    }
+
+    m_buffer = new Cell[buffer_size];
+    m_bufferMask = buffer_size - 1;
+    for (size_t i = 0; i < buffer_size; i++)
+    {
+        m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+BoundedQueue<T>::~BoundedQueue()
+{
+    delete [] m_buffer;
+}
+
+template <typename T>
+size_t BoundedQueue<T>::capacity() const
+{
+    return m_bufferMask + 1;
+}
+
+template <typename T>
+bool BoundedQueue<T>::tryEnqueue(const T &data)
+{
+    Cell *cell;
+    size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell = &m_buffer[position & m_bufferMask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0)
+        {
+            // The cell is free, try to claim it.
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The queue is full.
+            return false;
+        }
+        else
+        {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->data = data;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::tryDequeue(T &data)
+{
+    Cell *cell;
+    size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell = &m_buffer[position & m_bufferMask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+        if (difference == 0)
+        {
+            // The cell holds data, try to claim it.
+            if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The queue is empty.
+            return false;
+        }
+        else
+        {
+            position = m_dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    data = cell->data;
+    cell->data = T();
+    cell->sequence.store(position + m_bufferMask + 1, std::memory_order_release);
+
+    return true;
+}
+
+#endif // BOUNDEDQUEUE_H
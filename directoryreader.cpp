@@ -0,0 +1,156 @@
+// Qt
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+// Posix
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Local
+#include "directoryreader.h"
+
+#ifdef Q_OS_LINUX
+namespace
+{
+    // Record layout of getdents64, which the C library doesn't always declare.
+    struct LinuxDirent64
+    {
+        quint64 d_ino;
+        qint64 d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+}
+#endif
+
+const int DirectoryReader::m_BUFFER_SIZE(64 * 1024);
+
+DirectoryReader::DirectoryReader() :
+    m_directoryFd(-1),
+    m_buffer(),
+    m_bufferSize(0),
+    m_bufferOffset(0),
+    m_error(false),
+    m_directoryIterator()
+{
+}
+
+DirectoryReader::~DirectoryReader()
+{
+    this->close();
+}
+
+bool DirectoryReader::open(const QString &directoryPath)
+{
+    this->close();
+
+#ifdef Q_OS_LINUX
+    m_directoryFd = ::open(QFile::encodeName(directoryPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_directoryFd == -1)
+    {
+        return false;
+    }
+    m_buffer.resize(m_BUFFER_SIZE / sizeof(quint64));
+#else
+    m_directoryIterator.reset(new QDirIterator(directoryPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot));
+#endif
+
+    return true;
+}
+
+void DirectoryReader::close()
+{
+#ifdef Q_OS_LINUX
+    if (m_directoryFd != -1)
+    {
+        ::close(m_directoryFd);
+    }
+#endif
+    m_directoryFd = -1;
+    m_bufferSize = 0;
+    m_bufferOffset = 0;
+    m_error = false;
+    m_directoryIterator.reset();
+}
+
+bool DirectoryReader::next(QString &fileName, EntryType &entryType)
+{
+#ifdef Q_OS_LINUX
+    if (m_directoryFd == -1)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        // Refill the buffer once all of its entries have been handed out.
+        if (m_bufferOffset >= m_bufferSize)
+        {
+            long read_size = syscall(SYS_getdents64, m_directoryFd, m_buffer.data(), m_BUFFER_SIZE);
+            if (read_size <= 0)
+            {
+                m_error = read_size < 0;
+
+                return false;
+            }
+            m_bufferSize = static_cast<int>(read_size);
+            m_bufferOffset = 0;
+        }
+
+        const LinuxDirent64 *entry = reinterpret_cast<const LinuxDirent64 *>(reinterpret_cast<const char *>(m_buffer.constData()) + m_bufferOffset);
+        m_bufferOffset += entry->d_reclen;
+
+        // Skip what is known to be neither a file nor a directory.
+        if (entry->d_type != DT_REG && entry->d_type != DT_DIR && entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN)
+        {
+            continue;
+        }
+        if (qstrcmp(entry->d_name, ".") == 0 || qstrcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        fileName = QFile::decodeName(entry->d_name);
+        switch (entry->d_type)
+        {
+        case DT_REG:
+            entryType = EntryType_File;
+            break;
+        case DT_DIR:
+            entryType = EntryType_Directory;
+            break;
+        default:
+            entryType = EntryType_Unknown;
+        }
+
+        return true;
+    }
+#else
+    if (m_directoryIterator.isNull() || !m_directoryIterator->hasNext())
+    {
+        return false;
+    }
+
+    m_directoryIterator->next();
+    fileName = m_directoryIterator->fileName();
+    if (m_directoryIterator->fileInfo().isSymLink())
+    {
+        entryType = EntryType_Unknown;
+    }
+    else
+    {
+        entryType = m_directoryIterator->fileInfo().isDir() ? EntryType_Directory : EntryType_File;
+    }
+
+    return true;
+#endif
+}
+
+bool DirectoryReader::hasError() const
+{
+    return m_error;
+}
@@ -0,0 +1,48 @@
+#ifndef DIRECTORYREADER_H
+#define DIRECTORYREADER_H
+
+// Qt
+#include <QDirIterator>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+// Lists the files and subdirectories of a directory as they come, unsorted and without building a list of them.
+// On Linux the entries are read with getdents64 into a fixed buffer and typed from d_type,
+// so nothing is stat'ed: an entry the kernel could not type (or a symbolic link) is reported
+// as unknown and left for the caller to check. Elsewhere QDirIterator is used.
+class DirectoryReader
+{
+public:
+    enum EntryType
+    {
+        EntryType_File,
+        EntryType_Directory,
+        EntryType_Unknown
+    };
+
+private:
+    static const int m_BUFFER_SIZE;
+    int m_directoryFd;
+    QVector<quint64> m_buffer;
+    int m_bufferSize;
+    int m_bufferOffset;
+    bool m_error;
+    QScopedPointer<QDirIterator> m_directoryIterator;
+
+public:
+    DirectoryReader();
+    ~DirectoryReader();
+
+private:
+    DirectoryReader(const DirectoryReader &);
+    DirectoryReader &operator=(const DirectoryReader &);
+
+public:
+    bool open(const QString &directoryPath);
+    void close();
+    bool next(QString &fileName, EntryType &entryType);
+    bool hasError() const;
+};
+
+#endif // DIRECTORYREADER_H
@@ -0,0 +1,320 @@
+// Qt
+#include <QMutexLocker>
+#include <QRunnable>
+
+// Local
+#include "directorywalker.h"
+#include "directoryreader.h"
+
+const int DirectoryWalker::m_BATCH_SIZE(1024);
+const int DirectoryWalker::m_MAXIMUM_QUEUED_BATCH_COUNT(16);
+
+class DirectoryWalker::Scanner : public QRunnable
+{
+private:
+    DirectoryWalker *m_directoryWalker;
+    int m_scannerIndex;
+
+public:
+    Scanner(DirectoryWalker *directoryWalker, int scannerIndex) :
+        m_directoryWalker(directoryWalker),
+        m_scannerIndex(scannerIndex)
+    {
+    }
+
+public:
+    virtual void run()
+    {
+        m_directoryWalker->runScanner(m_scannerIndex);
+    }
+};
+
+DirectoryWalker::DirectoryWalker() :
+    m_fileFilters(NULL),
+    m_recursive(true),
+    m_threadPool(),
+    m_scannerCount(0),
+    m_directoryQueues(),
+    m_pendingDirectoryCount(0),
+    m_idleMutex(),
+    m_directoryAvailable(),
+    m_directoryCount(0),
+    m_stealCount(0),
+    m_errorCount(0),
+    m_batchMutex(),
+    m_batchQueued(),
+    m_batchTaken(),
+    m_batches(),
+    m_activeScannerCount(0)
+{
+}
+
+DirectoryWalker::DirectoryWalker(const FilterSet &fileFilters) :
+    m_fileFilters(&fileFilters),
+    m_recursive(true),
+    m_threadPool(),
+    m_scannerCount(0),
+    m_directoryQueues(),
+    m_pendingDirectoryCount(0),
+    m_idleMutex(),
+    m_directoryAvailable(),
+    m_directoryCount(0),
+    m_stealCount(0),
+    m_errorCount(0),
+    m_batchMutex(),
+    m_batchQueued(),
+    m_batchTaken(),
+    m_batches(),
+    m_activeScannerCount(0)
+{
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    this->wait();
+}
+
+void DirectoryWalker::setRecursive(bool recursive)
+{
+    m_recursive = recursive;
+}
+
+void DirectoryWalker::start(const QList<QDir> &directories, int scannerCount)
+{
+    m_scannerCount = qMax(scannerCount, 1);
+    m_directoryQueues.reset(new DirectoryQueue[m_scannerCount]);
+
+    // Deal the roots out to the scanners, stealing evens the load out from there.
+    for (int i = 0; i < directories.count(); i++)
+    {
+        this->pushDirectory(i % m_scannerCount, directories.at(i).absolutePath());
+    }
+
+    m_activeScannerCount = m_scannerCount;
+    m_threadPool.setMaxThreadCount(m_scannerCount);
+    for (int i = 0; i < m_scannerCount; i++)
+    {
+        m_threadPool.start(new Scanner(this, i));
+    }
+}
+
+bool DirectoryWalker::nextBatch(MatchedFileList &files)
+{
+    QMutexLocker mutex_locker(&m_batchMutex);
+    while (m_batches.isEmpty() && m_activeScannerCount > 0)
+    {
+        m_batchQueued.wait(&m_batchMutex);
+    }
+    if (m_batches.isEmpty())
+    {
+        return false;
+    }
+
+    files = m_batches.takeFirst();
+    m_batchTaken.wakeOne();
+
+    return true;
+}
+
+void DirectoryWalker::wait()
+{
+    // Drop whatever is left, so no scanner stays blocked on a full queue.
+    MatchedFileList files;
+    while (this->nextBatch(files))
+    {
+    }
+
+    m_threadPool.waitForDone();
+}
+
+int DirectoryWalker::directoryCount() const
+{
+    return m_directoryCount.load();
+}
+
+int DirectoryWalker::stealCount() const
+{
+    return m_stealCount.load();
+}
+
+int DirectoryWalker::errorCount() const
+{
+    return m_errorCount.load();
+}
+
+void DirectoryWalker::runScanner(int scannerIndex)
+{
+    MatchedFileList files;
+    QString directory_path;
+    for (;;)
+    {
+        if (this->takeDirectory(scannerIndex, directory_path))
+        {
+            this->scanDirectory(scannerIndex, directory_path, files);
+
+            // Subdirectories were counted when pushed, so this reaches zero only once the whole tree is done.
+            if (!m_pendingDirectoryCount.deref())
+            {
+                QMutexLocker mutex_locker(&m_idleMutex);
+                m_directoryAvailable.wakeAll();
+            }
+
+            continue;
+        }
+
+        // Nothing to scan or steal right now: hand over what was found, then wait for more work.
+        if (!files.isEmpty())
+        {
+            this->queueBatch(files);
+        }
+
+        // Check again under the lock the pushes and the end of the walk are signalled under, so no wake-up is missed.
+        QMutexLocker mutex_locker(&m_idleMutex);
+        while (m_pendingDirectoryCount.loadAcquire() != 0 && !this->hasQueuedDirectory())
+        {
+            m_directoryAvailable.wait(&m_idleMutex);
+        }
+        if (m_pendingDirectoryCount.loadAcquire() == 0)
+        {
+            break;
+        }
+    }
+
+    QMutexLocker mutex_locker(&m_batchMutex);
+    m_activeScannerCount--;
+    m_batchQueued.wakeAll();
+}
+
+bool DirectoryWalker::takeDirectory(int scannerIndex, QString &directoryPath)
+{
+    // Depth first on the scanner's own queue.
+    {
+        DirectoryQueue &directory_queue = m_directoryQueues[scannerIndex];
+        QMutexLocker mutex_locker(&directory_queue.mutex);
+        if (!directory_queue.directoryPaths.isEmpty())
+        {
+            directoryPath = directory_queue.directoryPaths.takeLast();
+
+            return true;
+        }
+    }
+
+    // Steal the oldest directory of another scanner, the one most likely to hold a large subtree.
+    for (int i = 1; i < m_scannerCount; i++)
+    {
+        DirectoryQueue &directory_queue = m_directoryQueues[(scannerIndex + i) % m_scannerCount];
+        QMutexLocker mutex_locker(&directory_queue.mutex);
+        if (!directory_queue.directoryPaths.isEmpty())
+        {
+            directoryPath = directory_queue.directoryPaths.takeFirst();
+            m_stealCount.ref();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DirectoryWalker::scanDirectory(int scannerIndex, const QString &directoryPath, MatchedFileList &files)
+{
+    DirectoryReader directory_reader;
+    if (!directory_reader.open(directoryPath))
+    {
+        m_errorCount.ref();
+
+        return;
+    }
+    m_directoryCount.ref();
+
+    QDir directory(directoryPath);
+    QString file_name;
+    DirectoryReader::EntryType entry_type;
+    while (directory_reader.next(file_name, entry_type))
+    {
+        QString file_path = directory.filePath(file_name);
+        if (entry_type == DirectoryReader::EntryType_Directory)
+        {
+            if (m_recursive)
+            {
+                this->pushDirectory(scannerIndex, file_path);
+            }
+
+            continue;
+        }
+
+        int file_filter_id = m_fileFilters != NULL ? m_fileFilters->match(file_name) : FilterSet::NO_MATCH;
+        bool file_matches = m_fileFilters == NULL || file_filter_id != FilterSet::NO_MATCH;
+        if (entry_type == DirectoryReader::EntryType_Unknown && (m_recursive || file_matches))
+        {
+            // The type is needed to know whether to descend or whether to hand the entry over, stat the entry.
+            QFileInfo file_info(file_path);
+            if (file_info.isDir() && !file_info.isSymLink())
+            {
+                if (m_recursive)
+                {
+                    this->pushDirectory(scannerIndex, file_path);
+                }
+
+                continue;
+            }
+            file_matches = file_matches && file_info.isFile();
+        }
+
+        if (file_matches)
+        {
+            files.append(MatchedFile(QFileInfo(file_path), file_filter_id));
+            if (files.count() == m_BATCH_SIZE)
+            {
+                this->queueBatch(files);
+            }
+        }
+    }
+    if (directory_reader.hasError())
+    {
+        m_errorCount.ref();
+    }
+}
+
+void DirectoryWalker::pushDirectory(int scannerIndex, const QString &directoryPath)
+{
+    m_pendingDirectoryCount.ref();
+
+    {
+        DirectoryQueue &directory_queue = m_directoryQueues[scannerIndex];
+        QMutexLocker mutex_locker(&directory_queue.mutex);
+        directory_queue.directoryPaths.append(directoryPath);
+    }
+
+    // Wake an idle scanner to take or steal it.
+    QMutexLocker mutex_locker(&m_idleMutex);
+    m_directoryAvailable.wakeOne();
+}
+
+bool DirectoryWalker::hasQueuedDirectory()
+{
+    for (int i = 0; i < m_scannerCount; i++)
+    {
+        DirectoryQueue &directory_queue = m_directoryQueues[i];
+        QMutexLocker mutex_locker(&directory_queue.mutex);
+        if (!directory_queue.directoryPaths.isEmpty())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DirectoryWalker::queueBatch(MatchedFileList &files)
+{
+    QMutexLocker mutex_locker(&m_batchMutex);
+    while (m_batches.count() >= m_MAXIMUM_QUEUED_BATCH_COUNT)
+    {
+        m_batchTaken.wait(&m_batchMutex);
+    }
+
+    m_batches.append(files);
+    files.clear();
+    m_batchQueued.wakeOne();
+}
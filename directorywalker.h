@@ -0,0 +1,81 @@
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+// Qt
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QList>
+#include <QMutex>
+#include <QScopedArrayPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+// Local
+#include "filterset.h"
+#include "matchedfile.h"
+
+// Walks directory trees on a pool of scanners and hands the files matching the filters over in batches
+// (every file, when built without filters, for the caller to match).
+// Every scanner keeps its own queue of directories to list: it pushes the subdirectories it finds
+// and takes the next directory from its end, and once it runs dry it steals from the front of
+// another scanner's queue, so wide and deep trees alike keep all the scanners busy.
+// The batches wait in a bounded queue, which holds the scanners back when the consumer is slower.
+// Symbolic links to directories are not followed. Without recursion only the given directories are listed.
+class DirectoryWalker
+{
+private:
+    class Scanner;
+    struct DirectoryQueue
+    {
+        QMutex mutex;
+        QStringList directoryPaths;
+    };
+    static const int m_BATCH_SIZE;
+    static const int m_MAXIMUM_QUEUED_BATCH_COUNT;
+    const FilterSet *m_fileFilters;
+    bool m_recursive;
+    QThreadPool m_threadPool;
+    int m_scannerCount;
+    QScopedArrayPointer<DirectoryQueue> m_directoryQueues;
+    QAtomicInt m_pendingDirectoryCount;
+    QMutex m_idleMutex;
+    QWaitCondition m_directoryAvailable;
+    QAtomicInt m_directoryCount;
+    QAtomicInt m_stealCount;
+    QAtomicInt m_errorCount;
+    QMutex m_batchMutex;
+    QWaitCondition m_batchQueued;
+    QWaitCondition m_batchTaken;
+    QList<MatchedFileList> m_batches;
+    int m_activeScannerCount;
+
+public:
+    DirectoryWalker();
+    explicit DirectoryWalker(const FilterSet &fileFilters);
+    ~DirectoryWalker();
+
+private:
+    DirectoryWalker(const DirectoryWalker &);
+    DirectoryWalker &operator=(const DirectoryWalker &);
+
+public:
+    void setRecursive(bool recursive);
+    void start(const QList<QDir> &directories, int scannerCount);
+    bool nextBatch(MatchedFileList &files);
+    void wait();
+    int directoryCount() const;
+    int stealCount() const;
+    int errorCount() const;
+
+private:
+    void runScanner(int scannerIndex);
+    bool takeDirectory(int scannerIndex, QString &directoryPath);
+    void scanDirectory(int scannerIndex, const QString &directoryPath, MatchedFileList &files);
+    void pushDirectory(int scannerIndex, const QString &directoryPath);
+    bool hasQueuedDirectory();
+    void queueBatch(MatchedFileList &files);
+};
+
+#endif // DIRECTORYWALKER_H
@@ -0,0 +1,199 @@
+// Std
+#include <cstring>
+
+// Qt
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+
+#ifdef Q_OS_WIN
+// Windows
+#include <windows.h>
+#else
+// Posix
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Local
+#include "duplicatecheck.h"
+
+const qint64 DuplicateCheck::m_CHUNK_SIZE(256 * 1024);
+
+bool DuplicateCheck::parseAction(const QString &actionName, Action &action)
+{
+    if (actionName == "off")
+    {
+        action = Action_Off;
+    }
+    else if (actionName == "skip")
+    {
+        action = Action_Skip;
+    }
+    else if (actionName == "link")
+    {
+        action = Action_Link;
+    }
+    else if (actionName == "quarantine")
+    {
+        action = Action_Quarantine;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool DuplicateCheck::isDuplicate(const QFileInfo &file, const QString &otherFilePath)
+{
+    // A file already bearing its new name is not a copy of itself.
+    QFileInfo other_file_info(otherFilePath);
+    if (!other_file_info.isFile() || other_file_info.absoluteFilePath() == file.absoluteFilePath())
+    {
+        return false;
+    }
+
+    // Different sizes settle it without reading anything.
+    if (other_file_info.size() != file.size())
+    {
+        return false;
+    }
+
+    QFile file_data(file.absoluteFilePath());
+    QFile other_file_data(otherFilePath);
+    if (!file_data.open(QIODevice::ReadOnly) || !other_file_data.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QByteArray buffer(m_CHUNK_SIZE, '\0');
+    QByteArray other_buffer(m_CHUNK_SIZE, '\0');
+    for (;;)
+    {
+        qint64 read_size = file_data.read(buffer.data(), m_CHUNK_SIZE);
+        qint64 other_read_size = other_file_data.read(other_buffer.data(), m_CHUNK_SIZE);
+        if (read_size < 0 || read_size != other_read_size)
+        {
+            return false;
+        }
+        if (read_size == 0)
+        {
+            return true;
+        }
+        if (memcmp(buffer.constData(), other_buffer.constData(), read_size) != 0)
+        {
+            return false;
+        }
+    }
+}
+
+bool DuplicateCheck::link(const QString &filePath, const QString &targetFilePath)
+{
+    // Already one file under two names.
+    if (DuplicateCheck::isSameFile(filePath, targetFilePath))
+    {
+        return true;
+    }
+
+    // Link under a temporary name, then replace the duplicate with it in one step, so its name never goes missing.
+    QString link_file_path = filePath + ".link";
+#ifdef Q_OS_WIN
+    QString link_path = QDir::toNativeSeparators(link_file_path);
+    QString target_path = QDir::toNativeSeparators(targetFilePath);
+    QString file_path = QDir::toNativeSeparators(filePath);
+    if (!CreateHardLinkW(reinterpret_cast<const wchar_t *>(link_path.utf16()), reinterpret_cast<const wchar_t *>(target_path.utf16()), NULL))
+    {
+        return false;
+    }
+    if (!MoveFileExW(reinterpret_cast<const wchar_t *>(link_path.utf16()), reinterpret_cast<const wchar_t *>(file_path.utf16()), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(reinterpret_cast<const wchar_t *>(link_path.utf16()));
+
+        return false;
+    }
+#else
+    QByteArray link_path = QFile::encodeName(link_file_path);
+    if (::link(QFile::encodeName(targetFilePath).constData(), link_path.constData()) != 0)
+    {
+        return false;
+    }
+    if (::rename(link_path.constData(), QFile::encodeName(filePath).constData()) != 0)
+    {
+        ::unlink(link_path.constData());
+
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool DuplicateCheck::separate(const QString &filePath)
+{
+    // Undoes a link: copy the contents under a temporary name, then replace the link with the copy in one step.
+    QString copy_file_path = filePath + ".copy";
+    if (!QFile::copy(filePath, copy_file_path))
+    {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    QString copy_path = QDir::toNativeSeparators(copy_file_path);
+    QString file_path = QDir::toNativeSeparators(filePath);
+    if (!MoveFileExW(reinterpret_cast<const wchar_t *>(copy_path.utf16()), reinterpret_cast<const wchar_t *>(file_path.utf16()), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(reinterpret_cast<const wchar_t *>(copy_path.utf16()));
+
+        return false;
+    }
+#else
+    QByteArray copy_path = QFile::encodeName(copy_file_path);
+    if (::rename(copy_path.constData(), QFile::encodeName(filePath).constData()) != 0)
+    {
+        ::unlink(copy_path.constData());
+
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool DuplicateCheck::isSameFile(const QString &filePath, const QString &otherFilePath)
+{
+#ifdef Q_OS_WIN
+    // The same file has the same index on the same volume.
+    BY_HANDLE_FILE_INFORMATION file_information[2];
+    const QString *file_paths[2] = { &filePath, &otherFilePath };
+    for (int i = 0; i < 2; i++)
+    {
+        QString file_path = QDir::toNativeSeparators(*file_paths[i]);
+        HANDLE file_handle = CreateFileW(reinterpret_cast<const wchar_t *>(file_path.utf16()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+        if (file_handle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        BOOL information_read = GetFileInformationByHandle(file_handle, &file_information[i]);
+        CloseHandle(file_handle);
+        if (!information_read)
+        {
+            return false;
+        }
+    }
+
+    return file_information[0].dwVolumeSerialNumber == file_information[1].dwVolumeSerialNumber &&
+           file_information[0].nFileIndexHigh == file_information[1].nFileIndexHigh &&
+           file_information[0].nFileIndexLow == file_information[1].nFileIndexLow;
+#else
+    struct stat file_stat;
+    struct stat other_file_stat;
+    if (::stat(QFile::encodeName(filePath).constData(), &file_stat) != 0 || ::stat(QFile::encodeName(otherFilePath).constData(), &other_file_stat) != 0)
+    {
+        return false;
+    }
+
+    return file_stat.st_dev == other_file_stat.st_dev && file_stat.st_ino == other_file_stat.st_ino;
+#endif
+}
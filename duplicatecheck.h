@@ -0,0 +1,33 @@
+#ifndef DUPLICATECHECK_H
+#define DUPLICATECHECK_H
+
+// Qt
+#include <QFileInfo>
+#include <QString>
+
+// Tells whether the file holding a target name is a byte-identical copy of the file being renamed,
+// as happens with files downloaded again, and deals with such a duplicate instead of giving it yet another name.
+// The sizes are compared first, then the contents chunk by chunk, stopping at the first difference.
+class DuplicateCheck
+{
+public:
+    enum Action
+    {
+        Action_Off,
+        Action_Skip,
+        Action_Link,
+        Action_Quarantine
+    };
+
+private:
+    static const qint64 m_CHUNK_SIZE;
+
+public:
+    static bool parseAction(const QString &actionName, Action &action);
+    static bool isDuplicate(const QFileInfo &file, const QString &otherFilePath);
+    static bool link(const QString &filePath, const QString &targetFilePath);
+    static bool separate(const QString &filePath);
+    static bool isSameFile(const QString &filePath, const QString &otherFilePath);
+};
+
+#endif // DUPLICATECHECK_H
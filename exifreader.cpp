@@ -0,0 +1,278 @@
+// Qt
+#include <QFile>
+#include <QByteArray>
+
+// Local
+#include "exifreader.h"
+
+const quint16 ExifReader::m_EXIF_IFD_POINTER_TAG(0x8769);
+const quint16 ExifReader::m_DATE_TIME_ORIGINAL_TAG(0x9003);
+const quint16 ExifReader::m_SUB_SEC_TIME_ORIGINAL_TAG(0x9291);
+
+ExifReader::ExifRead_RetVal ExifReader::readJpegDateTimeOriginal(const QString &filePath, QString &dateTimeOriginal, qint64 *bytesRead, QString *subSecTimeOriginal)
+{
+    if (bytesRead != NULL)
+    {
+        *bytesRead = 0;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return ExifRead_Unsupported;
+    }
+
+    return ExifReader::readJpegDateTimeOriginal(file, dateTimeOriginal, bytesRead, subSecTimeOriginal);
+}
+
+ExifReader::ExifRead_RetVal ExifReader::readJpegDateTimeOriginal(QIODevice &device, QString &dateTimeOriginal, qint64 *bytesRead, QString *subSecTimeOriginal)
+{
+    qint64 bytes_read = 0;
+    if (bytesRead != NULL)
+    {
+        *bytesRead = 0;
+    }
+
+    // Check the start of image marker.
+    uchar header[4];
+    if (device.read(reinterpret_cast<char *>(header), 2) != 2)
+    {
+        return ExifRead_Unsupported;
+    }
+    bytes_read += 2;
+    if (header[0] != 0xFF || header[1] != 0xD8)
+    {
+        if (bytesRead != NULL)
+        {
+            *bytesRead = bytes_read;
+        }
+
+        return ExifRead_Unsupported;
+    }
+
+    // Walk the segments up to the start of scan, looking for the Exif APP1 segment.
+    ExifRead_RetVal ret_val = ExifRead_NotFound;
+    forever
+    {
+        char marker_byte;
+        if (!device.getChar(&marker_byte))
+        {
+            ret_val = ExifRead_Unsupported;
+
+            break;
+        }
+        bytes_read++;
+        if (static_cast<uchar>(marker_byte) != 0xFF)
+        {
+            ret_val = ExifRead_Unsupported;
+
+            break;
+        }
+
+        // Skip fill bytes.
+        uchar marker = 0xFF;
+        while (marker == 0xFF)
+        {
+            if (!device.getChar(&marker_byte))
+            {
+                break;
+            }
+            bytes_read++;
+            marker = static_cast<uchar>(marker_byte);
+        }
+        if (marker == 0xFF)
+        {
+            ret_val = ExifRead_Unsupported;
+
+            break;
+        }
+
+        // Start of scan or end of image: there is no Exif segment.
+        if (marker == 0xDA || marker == 0xD9)
+        {
+            break;
+        }
+
+        // Markers without a payload.
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+        {
+            continue;
+        }
+
+        if (device.read(reinterpret_cast<char *>(header), 2) != 2)
+        {
+            ret_val = ExifRead_Unsupported;
+
+            break;
+        }
+        bytes_read += 2;
+        quint16 segment_length = ExifReader::readUInt16(header, true);
+        if (segment_length < 2)
+        {
+            ret_val = ExifRead_Unsupported;
+
+            break;
+        }
+        qint64 segment_data_length = segment_length - 2;
+
+        if (marker == 0xE1 && segment_data_length > 6)
+        {
+            QByteArray segment_data = device.read(segment_data_length);
+            bytes_read += segment_data.size();
+            if (segment_data.size() != segment_data_length)
+            {
+                ret_val = ExifRead_Unsupported;
+
+                break;
+            }
+            if (segment_data.startsWith(QByteArray("Exif\0\0", 6)))
+            {
+                const uchar *tiff_data = reinterpret_cast<const uchar *>(segment_data.constData()) + 6;
+                ret_val = ExifReader::parseTiffDateTimeOriginal(tiff_data, segment_data.size() - 6, dateTimeOriginal, subSecTimeOriginal);
+
+                break;
+            }
+
+            // Not Exif (e.g. XMP), keep looking.
+            continue;
+        }
+
+        if (!device.seek(device.pos() + segment_data_length))
+        {
+            ret_val = ExifRead_Unsupported;
+
+            break;
+        }
+    }
+
+    if (bytesRead != NULL)
+    {
+        *bytesRead = bytes_read;
+    }
+
+    return ret_val;
+}
+
+ExifReader::ExifRead_RetVal ExifReader::parseTiffDateTimeOriginal(const uchar *data, quint32 size, QString &dateTimeOriginal, QString *subSecTimeOriginal)
+{
+    // TIFF header: byte order, magic number and offset of IFD0.
+    if (size < 8)
+    {
+        return ExifRead_Unsupported;
+    }
+    bool big_endian;
+    if (data[0] == 'I' && data[1] == 'I')
+    {
+        big_endian = false;
+    }
+    else if (data[0] == 'M' && data[1] == 'M')
+    {
+        big_endian = true;
+    }
+    else
+    {
+        return ExifRead_Unsupported;
+    }
+    if (ExifReader::readUInt16(data + 2, big_endian) != 42)
+    {
+        return ExifRead_Unsupported;
+    }
+    quint32 ifd0_offset = ExifReader::readUInt32(data + 4, big_endian);
+
+    // IFD0 -> Exif IFD.
+    const uchar *exif_ifd_pointer_entry = ExifReader::findIfdEntry(data, size, ifd0_offset, m_EXIF_IFD_POINTER_TAG, big_endian);
+    if (exif_ifd_pointer_entry == NULL)
+    {
+        return ExifRead_NotFound;
+    }
+    quint32 exif_ifd_offset = ExifReader::readUInt32(exif_ifd_pointer_entry + 8, big_endian);
+
+    // Exif IFD -> DateTimeOriginal.
+    const uchar *date_time_original_entry = ExifReader::findIfdEntry(data, size, exif_ifd_offset, m_DATE_TIME_ORIGINAL_TAG, big_endian);
+    if (date_time_original_entry == NULL)
+    {
+        return ExifRead_NotFound;
+    }
+    ExifRead_RetVal ret_val = ExifReader::readAsciiEntry(data, size, date_time_original_entry, big_endian, dateTimeOriginal);
+
+    // Exif IFD -> SubSecTimeOriginal, which tells apart the shots of a burst. Without it the timestamp is still good.
+    if (ret_val == ExifRead_Found && subSecTimeOriginal != NULL)
+    {
+        subSecTimeOriginal->clear();
+        const uchar *sub_sec_time_original_entry = ExifReader::findIfdEntry(data, size, exif_ifd_offset, m_SUB_SEC_TIME_ORIGINAL_TAG, big_endian);
+        if (sub_sec_time_original_entry != NULL && ExifReader::readAsciiEntry(data, size, sub_sec_time_original_entry, big_endian, *subSecTimeOriginal) != ExifRead_Found)
+        {
+            subSecTimeOriginal->clear();
+        }
+    }
+
+    return ret_val;
+}
+
+ExifReader::ExifRead_RetVal ExifReader::readAsciiEntry(const uchar *data, quint32 size, const uchar *entry, bool bigEndian, QString &value)
+{
+    quint16 value_type = ExifReader::readUInt16(entry + 2, bigEndian);
+    quint32 value_count = ExifReader::readUInt32(entry + 4, bigEndian);
+    if (value_type != 2)
+    {
+        // Not an ASCII value, let Exiv2 deal with it.
+        return ExifRead_Unsupported;
+    }
+    const uchar *value_data = entry + 8;
+    if (value_count > 4)
+    {
+        quint32 value_offset = ExifReader::readUInt32(entry + 8, bigEndian);
+        if (value_offset > size || value_count > size - value_offset)
+        {
+            return ExifRead_Unsupported;
+        }
+        value_data = data + value_offset;
+    }
+
+    // The value ends at the first NUL, as in Exiv2::AsciiValue.
+    quint32 value_length = 0;
+    while (value_length < value_count && value_data[value_length] != '\0')
+    {
+        value_length++;
+    }
+    value = QString::fromLatin1(reinterpret_cast<const char *>(value_data), value_length);
+
+    return ExifRead_Found;
+}
+
+quint16 ExifReader::readUInt16(const uchar *data, bool bigEndian)
+{
+    return bigEndian ? static_cast<quint16>((data[0] << 8) | data[1])
+                     : static_cast<quint16>((data[1] << 8) | data[0]);
+}
+
+quint32 ExifReader::readUInt32(const uchar *data, bool bigEndian)
+{
+    return bigEndian ? (static_cast<quint32>(data[0]) << 24) | (static_cast<quint32>(data[1]) << 16) | (static_cast<quint32>(data[2]) << 8) | data[3]
+                     : (static_cast<quint32>(data[3]) << 24) | (static_cast<quint32>(data[2]) << 16) | (static_cast<quint32>(data[1]) << 8) | data[0];
+}
+
+const uchar *ExifReader::findIfdEntry(const uchar *data, quint32 size, quint32 ifdOffset, quint16 tag, bool bigEndian)
+{
+    // An IFD is a 2-byte entry count followed by 12-byte entries.
+    if (ifdOffset > size || size - ifdOffset < 2)
+    {
+        return NULL;
+    }
+    quint16 entry_count = ExifReader::readUInt16(data + ifdOffset, bigEndian);
+    if (static_cast<quint32>(entry_count) * 12 > size - ifdOffset - 2)
+    {
+        return NULL;
+    }
+
+    const uchar *entry = data + ifdOffset + 2;
+    for (quint16 i = 0; i < entry_count; i++, entry += 12)
+    {
+        if (ExifReader::readUInt16(entry, bigEndian) == tag)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,38 @@
+#ifndef EXIFREADER_H
+#define EXIFREADER_H
+
+// Qt
+#include <QIODevice>
+#include <QString>
+
+// Reads Exif.Photo.DateTimeOriginal, and optionally Exif.Photo.SubSecTimeOriginal, straight from the JPEG APP1 segment.
+// Only the segment headers up to the Exif block are read, and no Exiv2 metadata container is built.
+// Anything the reader cannot handle is reported as unsupported, so the caller can fall back to Exiv2.
+class ExifReader
+{
+public:
+    enum ExifRead_RetVal
+    {
+        ExifRead_Found,
+        ExifRead_NotFound,
+        ExifRead_Unsupported
+    };
+
+private:
+    static const quint16 m_EXIF_IFD_POINTER_TAG;
+    static const quint16 m_DATE_TIME_ORIGINAL_TAG;
+    static const quint16 m_SUB_SEC_TIME_ORIGINAL_TAG;
+
+public:
+    static ExifRead_RetVal readJpegDateTimeOriginal(const QString &filePath, QString &dateTimeOriginal, qint64 *bytesRead = NULL, QString *subSecTimeOriginal = NULL);
+    static ExifRead_RetVal readJpegDateTimeOriginal(QIODevice &device, QString &dateTimeOriginal, qint64 *bytesRead = NULL, QString *subSecTimeOriginal = NULL);
+    static ExifRead_RetVal parseTiffDateTimeOriginal(const uchar *data, quint32 size, QString &dateTimeOriginal, QString *subSecTimeOriginal = NULL);
+
+private:
+    static quint16 readUInt16(const uchar *data, bool bigEndian);
+    static quint32 readUInt32(const uchar *data, bool bigEndian);
+    static ExifRead_RetVal readAsciiEntry(const uchar *data, quint32 size, const uchar *entry, bool bigEndian, QString &value);
+    static const uchar *findIfdEntry(const uchar *data, quint32 size, quint32 ifdOffset, quint16 tag, bool bigEndian);
+};
+
+#endif // EXIFREADER_H
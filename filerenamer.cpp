@@ -1,14 +1,26 @@
 // Qt
 #include <QDateTime>
-#include <QRegularExpressionMatch>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 // Exiv2
 #include <exiv2/exiv2.hpp>
 
 // Local
 #include "filerenamer.h"
+#include "filterrules.h"
+#include "exifreader.h"
+#include "windowedfileio.h"
+#include "directoryreader.h"
+#include "directorywalker.h"
+#include "imageformat.h"
 
+const int FileRenamer::m_FILE_BATCH_SIZE(1024);
+const int FileRenamer::m_FILE_LIST_CHUNK_SIZE(64 * 1024);
 const QString FileRenamer::m_IMAGE_TIMESTAMP_TAG("Exif.Photo.DateTimeOriginal");
+const QString FileRenamer::m_IMAGE_SUB_SECOND_TAG("Exif.Photo.SubSecTimeOriginal");
 const QString FileRenamer::m_TUMBLR_FILTER_1("^https?%[0-9a-fA-F]{2}%[0-9a-fA-F]{2}%[0-9a-fA-F]{4}.media.tumblr.com(%[0-9a-fA-F]{34})?%[0-9a-fA-F]{2}tumblr_[0-9a-zA-Z]{19}(_.{2})?_[0-9]{3,4}\\.(?i)(jpe?g|png|gif|bmp)$");
 const QString FileRenamer::m_TUMBLR_FILTER_2("^tumblr_[\\w]{19}_[0-9]{3,4}\\.(?i)(jpe?g|png|gif|bmp)$");
 const QString FileRenamer::m_TUMBLR_FILTER_3("^tumblr_[\\w]{19,20}_[\\w]{2}_[0-9]{3}\\.(?i)(jpe?g|png|gif|bmp)$");
@@ -25,26 +37,72 @@ FileRenamer::FileRenamer(QObject *parent) :
     Base("FR", parent),
     m_fileFilters(),
     m_totalFileCount(0),
-    m_renamedFileCount(0)
+    m_renamedFileCount(0),
+    m_jobCount(1),
+    m_nameReservation(),
+    m_nameTemplate(),
+    m_millisecondNameTemplate(),
+    m_renamePlan(),
+    m_renameJournal(),
+    m_metadataCache(),
+    m_fileLatencyRecording(false),
+    m_fileLatencies(),
+    m_renameStatistics(),
+    m_atomicRename(),
+    m_recursive(false),
+    m_renamePipeline(this),
+    m_pipelineEnabled(false),
+    m_duplicateAction(DuplicateCheck::Action_Off),
+    m_quarantineDirectoryPath(),
+    m_duplicateCount(0),
+    m_archiveRootPath(),
+    m_targetDirectoryPaths(),
+    m_renamedFilePaths()
 {
-    m_fileFilters << m_TUMBLR_FILTER_1
-                  << m_TUMBLR_FILTER_2
-                  << m_TUMBLR_FILTER_3
-                  << m_TUMBLR_FILTER_4
-                  << m_PHONEGRAM_FILTER
-                  << m_TELEGRAM_FILTER
-                  << m_RUNKEEPER_APP_FILTER
-                  << m_RUNKEEPER_WEB_FILTER
-                  << m_FLIPBOARD_FILTER
-                  << m_GOOGLE_IMAGES_FILTER
-                  << m_ANDROID_FILTER;
+    m_fileFilters.addFilter("Tumblr 1", m_TUMBLR_FILTER_1);
+    m_fileFilters.addFilter("Tumblr 2", m_TUMBLR_FILTER_2);
+    m_fileFilters.addFilter("Tumblr 3", m_TUMBLR_FILTER_3);
+    m_fileFilters.addFilter("Tumblr 4", m_TUMBLR_FILTER_4);
+    m_fileFilters.addFilter("Phonegram", m_PHONEGRAM_FILTER, NameTimestampDecoder::Decoder_DateTime);
+    m_fileFilters.addFilter("Telegram", m_TELEGRAM_FILTER);
+    m_fileFilters.addFilter("Runkeeper app", m_RUNKEEPER_APP_FILTER, NameTimestampDecoder::Decoder_EpochMilliseconds);
+    m_fileFilters.addFilter("Runkeeper web", m_RUNKEEPER_WEB_FILTER);
+    m_fileFilters.addFilter("Flipboard", m_FLIPBOARD_FILTER);
+    m_fileFilters.addFilter("Google Images", m_GOOGLE_IMAGES_FILTER);
+    m_fileFilters.addFilter("Android", m_ANDROID_FILTER, NameTimestampDecoder::Decoder_DateTime);
 
-    this->debug("File renamer created");
+    // State what every name matched by each filter has in common: length, extension and literal parts.
+    // Names failing all of these never reach the expression, which is most names in a typical directory.
+    QStringList image_extensions;
+    image_extensions << "jpg" << "jpeg" << "png" << "gif" << "bmp";
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Tumblr 1"), FilterSet::Prefilter(69, 110, image_extensions, "http", "tumblr_"));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Tumblr 2"), FilterSet::Prefilter(34, 36, image_extensions, "tumblr_"));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Tumblr 3"), FilterSet::Prefilter(37, 39, image_extensions, "tumblr_"));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Tumblr 4"), FilterSet::Prefilter(40, 41, image_extensions));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Phonegram"), FilterSet::Prefilter(27, 28, image_extensions, "IMG_"));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Telegram"), FilterSet::Prefilter(19, 21, image_extensions));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Runkeeper app"), FilterSet::Prefilter(17, 18, image_extensions));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Runkeeper web"), FilterSet::Prefilter(28, 29, image_extensions));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Flipboard"), FilterSet::Prefilter(44, 45, image_extensions));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Google Images"), FilterSet::Prefilter(40, 41, image_extensions));
+    m_fileFilters.setPrefilter(m_fileFilters.filterId("Android"), FilterSet::Prefilter(23, 24, image_extensions, "IMG_"));
+
+    // Compile all the filters once into a single expression.
+    QString error_string;
+    if (!m_fileFilters.compile(&error_string))
+    {
+        LOG_ERROR(error_string);
+    }
+
+    m_nameTemplate.compile(NameTemplate::DEFAULT_TEMPLATE);
+    m_millisecondNameTemplate.compile(NameTemplate::millisecondTemplate(NameTemplate::DEFAULT_TEMPLATE));
+
+    LOG_DEBUG("File renamer created");
 }
 
 FileRenamer::~FileRenamer()
 {
-    this->debug("File renamer disposed of");
+    LOG_DEBUG("File renamer disposed of");
 }
 
 int FileRenamer::totalFileCount() const
@@ -57,196 +115,1407 @@ int FileRenamer::renamedFileCount() const
     return m_renamedFileCount;
 }
 
+const FilterSet &FileRenamer::fileFilters() const
+{
+    return m_fileFilters;
+}
+
+bool FileRenamer::loadFilterRules(const QString &rulesFilePath)
+{
+    // The rules replace the built-in filters altogether.
+    FilterSet file_filters;
+    QString error_string;
+    bool cache_used = false;
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+    if (!FilterRules::load(rulesFilePath, file_filters, &error_string, &cache_used))
+    {
+        LOG_ERROR(error_string);
+
+        return false;
+    }
+    m_fileFilters = file_filters;
+
+    LOG_DEBUG(QString("%1 filter rules loaded in %2 ms (%3)")
+              .arg(m_fileFilters.count())
+              .arg(elapsed_timer.nsecsElapsed() / 1e6, 0, 'f', 2)
+              .arg(cache_used ? "cached" : "compiled"));
+
+    return true;
+}
+
+int FileRenamer::jobCount() const
+{
+    return m_jobCount;
+}
+
+void FileRenamer::setJobCount(int jobCount)
+{
+    m_jobCount = qMax(jobCount, 1);
+}
+
+int FileRenamer::nameLookupCount()
+{
+    return m_nameReservation.lookupCount();
+}
+
+int FileRenamer::nameDirectoryListingCount()
+{
+    return m_nameReservation.directoryListingCount();
+}
+
+// Reads image timestamps on the worker threads of the parallel mode.
+class FileRenamer::ImageTimestampReader
+{
+private:
+    FileRenamer *m_fileRenamer;
+
+public:
+    typedef FileRenamer::ImageTimestamp result_type;
+
+    explicit ImageTimestampReader(FileRenamer *fileRenamer) :
+        m_fileRenamer(fileRenamer)
+    {
+    }
+
+    result_type operator()(const MatchedFile &file) const
+    {
+        return m_fileRenamer->readImageTimestamp(file);
+    }
+};
+
 void FileRenamer::processDirectories(const QList<QDir> &directories)
 {
+    if (m_pipelineEnabled)
+    {
+        this->renameDirectoriesPipelined(directories);
+
+        return;
+    }
+    if (m_recursive)
+    {
+        this->renameDirectoryTrees(directories);
+
+        return;
+    }
+
     // Process directories.
     foreach (const QDir &directory, directories)
     {
-        this->debug("================");
+        LOG_DEBUG("================");
 
-        this->debug("Directory: " + directory.dirName());
+        LOG_DEBUG("Directory: " + directory.dirName());
 
-        this->renameFiles(directory);
+        this->renameDirectory(directory);
     }
 }
 
-void FileRenamer::processFiles(const QFileInfoList &files)
+bool FileRenamer::isRecursive() const
 {
-    // Process files.
-    foreach (const QFileInfo &file, files)
+    return m_recursive;
+}
+
+void FileRenamer::setRecursive(bool recursive)
+{
+    m_recursive = recursive;
+}
+
+bool FileRenamer::isPipelineEnabled() const
+{
+    return m_pipelineEnabled;
+}
+
+void FileRenamer::setPipelineEnabled(bool pipelineEnabled)
+{
+    m_pipelineEnabled = pipelineEnabled;
+}
+
+void FileRenamer::setPipelineThreadCount(RenamePipeline::Stage stage, int threadCount)
+{
+    m_renamePipeline.setThreadCount(stage, threadCount);
+}
+
+void FileRenamer::setPipelineQueueCapacity(int queueCapacity)
+{
+    m_renamePipeline.setQueueCapacity(queueCapacity);
+}
+
+bool FileRenamer::setNameTemplate(const QString &nameTemplate)
+{
+    QString error_string;
+    if (!m_nameTemplate.compile(nameTemplate, &error_string))
     {
-        this->debug("----------------");
+        LOG_ERROR(error_string);
 
-        FileRename_RetVal ret_val = renameFile(file);
-        switch (ret_val)
-        {
-        case FileRename_Success:
-        case FileRename_Skipped:
-            break;
-        case FileRename_Error:
-        default:
-            this->warning("Cannot rename file: " + file.fileName());
-        }
+        return false;
     }
+    m_millisecondNameTemplate.compile(NameTemplate::millisecondTemplate(nameTemplate));
+
+    return true;
 }
 
-void FileRenamer::renameFiles(const QDir &directory)
+bool FileRenamer::setArchiveRoot(const QString &archiveRootPath)
 {
-    QFileInfoList files = directory.entryInfoList(QDir::Files, QDir::Name);
+    // Nothing is created here: a plan must leave the disk untouched, the buckets are created by the renames.
+    QFileInfo archive_root_info(archiveRootPath);
+    if (archive_root_info.exists() && !archive_root_info.isDir())
+    {
+        LOG_ERROR("The archive root is not a directory: " + archiveRootPath);
 
-    foreach (const QFileInfo &file, files)
+        return false;
+    }
+
+    m_archiveRootPath = QDir(archiveRootPath).absolutePath();
+    m_targetDirectoryPaths.clear();
+
+    return true;
+}
+
+bool FileRenamer::setDuplicateAction(DuplicateCheck::Action duplicateAction, const QString &quarantineDirectoryPath)
+{
+    // Duplicates are moved with a rename, so the quarantine directory should be on the same filesystem.
+    // It is only created when the first duplicate is moved to it, like the archive buckets.
+    if (duplicateAction == DuplicateCheck::Action_Quarantine && quarantineDirectoryPath.isEmpty())
     {
-        this->debug("----------------");
+        LOG_ERROR("Missing quarantine directory");
+
+        return false;
+    }
+
+    m_duplicateAction = duplicateAction;
+    m_quarantineDirectoryPath = QDir(quarantineDirectoryPath).absolutePath();
 
-        FileRename_RetVal ret_val = renameFile(file);
-        switch (ret_val)
+    return true;
+}
+
+int FileRenamer::duplicateCount() const
+{
+    return m_duplicateCount;
+}
+
+bool FileRenamer::setNameTimestampMode(const QString &filterName, NameTimestampDecoder::Mode nameTimestampMode)
+{
+    // No filter name means all the filters.
+    if (filterName.isEmpty())
+    {
+        for (int i = 0; i < m_fileFilters.count(); i++)
         {
-        case FileRename_Success:
-        case FileRename_Skipped:
-            break;
-        case FileRename_Error:
-        default:
-            this->warning("Cannot rename file: " + file.fileName());
+            m_fileFilters.setNameTimestampMode(i, nameTimestampMode);
         }
+
+        return true;
+    }
+
+    int file_filter_id = m_fileFilters.filterId(filterName);
+    if (file_filter_id == -1 || m_fileFilters.nameTimestampDecoder(file_filter_id) == NameTimestampDecoder::Decoder_None)
+    {
+        return false;
     }
+    m_fileFilters.setNameTimestampMode(file_filter_id, nameTimestampMode);
+
+    return true;
 }
 
-FileRenamer::FileRename_RetVal FileRenamer::renameFile(const QFileInfo &file)
+void FileRenamer::processFiles(const QFileInfoList &files)
 {
-    QString file_name = file.fileName();
+    // Select the files to rename, each name is matched against the filters once.
+    MatchedFileList matching_files;
+    foreach (const QFileInfo &file, files)
+    {
+        int file_filter_id = this->matchFilters(file);
+        if (file_filter_id != FilterSet::NO_MATCH)
+        {
+            matching_files.append(MatchedFile(file, file_filter_id));
+        }
+    }
 
-    this->debug("Current file: " + file_name);
+    // Process files.
+    this->renameFiles(matching_files);
+}
 
-    // Check if the current file needs to be renamed.
-    bool file_filter_match = false;
-    foreach (const QString &image_filter, m_fileFilters)
+void FileRenamer::processFileList(QIODevice &fileList, char separator)
+{
+    // Read the list in chunks and rename in batches, so memory stays the same however long the list is.
+    MatchedFileList files;
+    files.reserve(m_FILE_BATCH_SIZE);
+    QByteArray pending_data;
+    forever
     {
-        QRegularExpression regular_expression(image_filter);
-        QRegularExpressionMatch regular_expression_match = regular_expression.match(file_name);
-        if (regular_expression_match.hasMatch())
+        QByteArray chunk = fileList.read(m_FILE_LIST_CHUNK_SIZE);
+        if (chunk.isEmpty())
         {
-            file_filter_match = true;
+            break;
+        }
+        pending_data.append(chunk);
 
-            continue;
+        // Hand over every complete path, keep the partial one for the next chunk.
+        int path_start = 0;
+        int separator_index;
+        while ((separator_index = pending_data.indexOf(separator, path_start)) != -1)
+        {
+            this->appendListedFile(files, pending_data.mid(path_start, separator_index - path_start), separator);
+            path_start = separator_index + 1;
         }
+        pending_data.remove(0, path_start);
     }
-    if (!file_filter_match)
-    {
-        this->debug("File " + file_name + " doesn't match any of the filters, skipping...");
 
-        return FileRename_Skipped;
+    // The last path may come without a separator.
+    this->appendListedFile(files, pending_data, separator);
+
+    this->renameFiles(files);
+}
+
+void FileRenamer::setFileLatencyRecording(bool fileLatencyRecording)
+{
+    m_fileLatencyRecording = fileLatencyRecording;
+}
+
+const QVector<qint64> &FileRenamer::fileLatencies() const
+{
+    return m_fileLatencies;
+}
+
+void FileRenamer::setStatisticsEnabled(bool statisticsEnabled)
+{
+    m_renameStatistics.setEnabled(statisticsEnabled);
+}
+
+QStringList FileRenamer::statisticsReport() const
+{
+    QStringList statistics_report = m_renameStatistics.report();
+    if (m_pipelineEnabled)
+    {
+        statistics_report << m_renamePipeline.report();
     }
 
-    // Increase the number of total files to rename.
-    m_totalFileCount++;
+    return statistics_report;
+}
 
-    QString file_absolute_path = file.absoluteFilePath();
-    QString exif_data_image_timestamp;
-    try
+bool FileRenamer::openPlan(const QString &planFilePath)
+{
+    return m_renamePlan.open(planFilePath);
+}
+
+void FileRenamer::closePlan()
+{
+    m_renamePlan.close();
+}
+
+bool FileRenamer::applyPlan(const QString &planFilePath)
+{
+    QFile plan_file(planFilePath);
+    if (!plan_file.open(QIODevice::ReadOnly))
     {
-        std::string image_absolute_path_string = file_absolute_path.toStdString();
-        Exiv2::Image::AutoPtr image = Exiv2::ImageFactory::open(image_absolute_path_string);
-        if (image.get() == NULL)
-        {
-            this->warning("Cannot load image: " + file_name);
+        LOG_ERROR("Cannot open the rename plan: " + planFilePath);
 
-            return FileRename_Error;
+        return false;
+    }
+
+    // Nothing but renames here: the names were checked when the plan was made,
+    // and a file created since then is never overwritten.
+    while (!plan_file.atEnd())
+    {
+        QByteArray line = plan_file.readLine().trimmed();
+        if (line.isEmpty())
+        {
+            continue;
         }
 
-        image->readMetadata();
-        Exiv2::ExifData &exif_data = image->exifData();
-        Exiv2::ExifKey exif_key(m_IMAGE_TIMESTAMP_TAG.toStdString());
-        Exiv2::ExifData::const_iterator pos = exif_data.findKey(exif_key);
-        if (pos != exif_data.end())
+        // Increase the number of total files to rename.
+        m_totalFileCount++;
+
+        RenamePlan::Entry entry;
+        if (!RenamePlan::parseEntry(line, entry))
         {
-            QString exif_data_value = QString::fromStdString(pos->toString());
-            QStringList exif_data_image_timestamp_date_time_split = exif_data_value.split(' ');
-            if (exif_data_image_timestamp_date_time_split.size() < 2)
-            {
-                this->warning("Invalid image timestamp");
+            LOG_WARNING("Invalid rename plan entry: " + QString::fromUtf8(line));
 
-                return FileRename_Error;
-            }
+            continue;
+        }
 
-            QString exif_data_image_timestamp_date = exif_data_image_timestamp_date_time_split.at(0);
-            exif_data_image_timestamp_date.replace(':', '-');
-            QString exif_data_image_timestamp_time = exif_data_image_timestamp_date_time_split.at(1);
-            exif_data_image_timestamp_time.replace(':', '.');
-            exif_data_image_timestamp = exif_data_image_timestamp_date + " " + exif_data_image_timestamp_time;
+        // An archive plan may move files to buckets that don't exist yet.
+        bool ret_val = this->createTargetDirectory(entry.to);
+        if (ret_val)
+        {
+            RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_Rename);
+            ret_val = m_atomicRename.rename(entry.from, entry.to) == AtomicRename::AtomicRename_Success;
         }
-        else
+        if (!ret_val)
         {
-            this->debug("No image timestamp, using file attributes...");
+            LOG_WARNING("Cannot rename file " + entry.from + " to: " + entry.to);
 
-            QDateTime image_file_last_modified_time = file.lastModified();
-            exif_data_image_timestamp = image_file_last_modified_time.toString("yyyy-MM-dd HH.mm.ss");
+            continue;
         }
+
+        m_renamedFileCount++;
     }
-    catch (Exiv2::AnyError &e)
-    {
-        this->error("Caught Exiv2 exception: " + QString(e.what()));
 
-        return FileRename_Error;
+    LOG_DEBUG("Files renamed: " + QString::number(m_renamedFileCount) + "/" + QString::number(m_totalFileCount));
+
+    return true;
+}
+
+bool FileRenamer::openJournal(const QString &journalFilePath, bool append)
+{
+    return m_renameJournal.open(journalFilePath, append);
+}
+
+void FileRenamer::closeJournal()
+{
+    if (m_renameJournal.hasPendingEntries())
+    {
+        this->commitJournalGroup();
     }
 
-    this->debug("Image timestamp: " + exif_data_image_timestamp);
+    m_renameJournal.close();
+}
+
+bool FileRenamer::openMetadataCache(const QString &cacheFilePath)
+{
+    bool ret_val = m_metadataCache.open(cacheFilePath);
+
+    LOG_DEBUG("Metadata cache entries: " + QString::number(m_metadataCache.recordCount()));
+
+    return ret_val;
+}
+
+bool FileRenamer::closeMetadataCache()
+{
+    bool ret_val = m_metadataCache.save();
+    m_metadataCache.close();
+
+    return ret_val;
+}
+
+void FileRenamer::setJournalGroupSize(int journalGroupSize)
+{
+    m_renameJournal.setGroupSize(journalGroupSize);
+}
 
-    QString new_image_name = exif_data_image_timestamp + "." + file.completeSuffix();
+int FileRenamer::journalSyncCount() const
+{
+    return m_renameJournal.syncCount();
+}
+
+bool FileRenamer::resumeJournal(const QString &journalFilePath)
+{
+    QList<RenamePlan::Entry> entries;
+    if (!RenameJournal::read(journalFilePath, entries))
+    {
+        LOG_ERROR("Cannot read the rename journal: " + journalFilePath);
 
-    this->debug("New image name: "+ new_image_name);
+        return false;
+    }
 
-    QDir file_absolute_directory(file.absoluteDir());
-    QString new_image_file_name = file_absolute_directory.filePath(new_image_name);
-    QFileInfo new_image_file_info(new_image_file_name);
-    if (new_image_file_info.exists())
+    // Finish the renames that were logged but not performed before the interruption.
+    // The files already renamed no longer match the filters, so the rest of the run skips them.
+    int completed_rename_count = 0;
+    int finished_rename_count = 0;
+    foreach (const RenamePlan::Entry &entry, entries)
     {
-        this->warning("File " + new_image_name + " already exists");
+        bool from_exists = QFileInfo::exists(entry.from);
+        bool to_exists = QFileInfo::exists(entry.to);
+
+        // A link is done once both names lead to the same file. The copy is checked again before linking it.
+        if (entry.type == RenamePlan::Type_Link)
+        {
+            if (DuplicateCheck::isSameFile(entry.from, entry.to))
+            {
+                completed_rename_count++;
+            }
+            else if (DuplicateCheck::isDuplicate(QFileInfo(entry.from), entry.to) && DuplicateCheck::link(entry.from, entry.to))
+            {
+                finished_rename_count++;
+            }
+            else if (from_exists && to_exists)
+            {
+                LOG_WARNING("Cannot link file " + entry.from + " to: " + entry.to);
+            }
+
+            continue;
+        }
 
-        // Try with subsequent timestamps for a minute.
-        this->debug("Trying with subsequent timestamps...");
-        bool new_image_file_name_found = false;
-        QDateTime current_image_timestamp = QDateTime::fromString(exif_data_image_timestamp, "yyyy-MM-dd HH.mm.ss");
-        for (int i = 0; i < 60; i++)
+        if (!from_exists && to_exists)
+        {
+            completed_rename_count++;
+        }
+        else if (from_exists && !to_exists)
         {
-            current_image_timestamp = current_image_timestamp.addSecs(1);
+            if (this->createTargetDirectory(entry.to) && m_atomicRename.rename(entry.from, entry.to) == AtomicRename::AtomicRename_Success)
+            {
+                finished_rename_count++;
+            }
+            else
+            {
+                LOG_WARNING("Cannot rename file " + entry.from + " to: " + entry.to);
+            }
+        }
+    }
+
+    LOG_DEBUG("Journal renames already completed: " + QString::number(completed_rename_count) + ", finished now: " + QString::number(finished_rename_count));
+
+    return true;
+}
 
-            exif_data_image_timestamp = current_image_timestamp.toString("yyyy-MM-dd HH.mm.ss");
+bool FileRenamer::undoJournal(const QString &journalFilePath)
+{
+    QList<RenamePlan::Entry> entries;
+    if (!RenameJournal::read(journalFilePath, entries))
+    {
+        LOG_ERROR("Cannot read the rename journal: " + journalFilePath);
+
+        return false;
+    }
 
-            //this->debug("Image timestamp: " + exif_data_image_timestamp);
+    // Reverse the renames, last one first, so names freed by later renames are restored in order.
+    for (int i = entries.count() - 1; i >= 0; i--)
+    {
+        const RenamePlan::Entry &entry = entries.at(i);
 
-            new_image_name = exif_data_image_timestamp + "." + file.completeSuffix();
+        // A linked duplicate gets its own copy of the contents back.
+        if (entry.type == RenamePlan::Type_Link)
+        {
+            if (!DuplicateCheck::isSameFile(entry.from, entry.to))
+            {
+                // Never performed, or already undone.
+                continue;
+            }
 
-            this->debug("New image name: "+ new_image_name);
+            // Increase the number of total files to rename.
+            m_totalFileCount++;
 
-            new_image_file_name = file_absolute_directory.filePath(new_image_name);
-            new_image_file_info.setFile(new_image_file_name);
-            if (!new_image_file_info.exists())
+            if (!DuplicateCheck::separate(entry.from))
             {
-                new_image_file_name_found = true;
+                LOG_WARNING("Cannot unlink file " + entry.from + " from: " + entry.to);
 
-                break;
+                continue;
             }
+
+            m_renamedFileCount++;
+
+            continue;
         }
 
-        if (!new_image_file_name_found)
+        if (!QFileInfo::exists(entry.to) || QFileInfo::exists(entry.from))
         {
-            return FileRename_Error;
+            // Never performed, or already undone.
+            continue;
+        }
+
+        // Increase the number of total files to rename.
+        m_totalFileCount++;
+
+        if (m_atomicRename.rename(entry.to, entry.from) != AtomicRename::AtomicRename_Success)
+        {
+            LOG_WARNING("Cannot rename file " + entry.to + " back to: " + entry.from);
+
+            continue;
         }
+
+        m_renamedFileCount++;
+    }
+
+    LOG_DEBUG("Files restored: " + QString::number(m_renamedFileCount) + "/" + QString::number(m_totalFileCount));
+
+    return true;
+}
+
+void FileRenamer::renameDirectory(const QDir &directory)
+{
+    DirectoryReader directory_reader;
+    if (!directory_reader.open(directory.absolutePath()))
+    {
+        LOG_WARNING("Cannot read directory: " + directory.absolutePath());
+
+        return;
     }
 
-    // Rename the file.
-    QFile new_image_file(file_absolute_path);
-    bool ret_val = new_image_file.rename(new_image_file_name);
-    if (!ret_val)
+    // Hand the files over in batches as they are listed, so the first renames don't wait for the
+    // whole listing and memory doesn't grow with the directory. Renamed files may show up again
+    // later in the listing under their new name: those are recognized and skipped when renaming.
+    MatchedFileList files;
+    files.reserve(m_FILE_BATCH_SIZE);
+    QString file_name;
+    DirectoryReader::EntryType entry_type;
+    while (directory_reader.next(file_name, entry_type))
     {
-        this->warning("Cannot rename file to: "+ new_image_name);
+        if (entry_type == DirectoryReader::EntryType_Directory)
+        {
+            continue;
+        }
 
-        return FileRename_Error;
+        QFileInfo file(directory, file_name);
+        int file_filter_id = this->matchFilters(file);
+        if (file_filter_id == FilterSet::NO_MATCH)
+        {
+            continue;
+        }
+
+        // Only stat an entry of unknown type if its name would be renamed.
+        if (entry_type == DirectoryReader::EntryType_Unknown && !file.isFile())
+        {
+            continue;
+        }
+
+        files.append(MatchedFile(file, file_filter_id));
+        if (files.count() == m_FILE_BATCH_SIZE)
+        {
+            this->renameFiles(files);
+            files.clear();
+        }
+    }
+    if (directory_reader.hasError())
+    {
+        LOG_WARNING("Error reading directory: " + directory.absolutePath());
     }
 
-    this->debug("File renamed to: " + new_image_file_info.absoluteFilePath());
+    this->renameFiles(files);
+}
 
-    this->debug("Files renamed: " + QString::number(++m_renamedFileCount) + "/" + QString::number(m_totalFileCount));
+void FileRenamer::renameDirectoryTrees(const QList<QDir> &directories)
+{
+    LOG_DEBUG("================");
 
-    return FileRename_Success;
+    // The scanners walk the trees while this thread renames what they found so far.
+    DirectoryWalker directory_walker(m_fileFilters);
+    directory_walker.start(directories, m_jobCount);
+    MatchedFileList files;
+    while (directory_walker.nextBatch(files))
+    {
+        this->renameFiles(files);
+    }
+
+    LOG_DEBUG("Directories walked: " + QString::number(directory_walker.directoryCount()) + " (stolen: " + QString::number(directory_walker.stealCount()) + ")");
+
+    if (directory_walker.errorCount() > 0)
+    {
+        LOG_WARNING("Cannot read " + QString::number(directory_walker.errorCount()) + " directories");
+    }
+}
+
+void FileRenamer::appendListedFile(MatchedFileList &files, const QByteArray &filePath, char separator)
+{
+    QByteArray file_path(filePath);
+    if (separator == '\n' && file_path.endsWith('\r'))
+    {
+        file_path.chop(1);
+    }
+    if (file_path.isEmpty())
+    {
+        return;
+    }
+
+    // Names that don't match the filters are skipped without touching the file, only the matching ones are stat'ed.
+    QFileInfo file(QFile::decodeName(file_path));
+    int file_filter_id = this->matchFilters(file);
+    if (file_filter_id == FilterSet::NO_MATCH || !file.isFile())
+    {
+        return;
+    }
+
+    files.append(MatchedFile(file, file_filter_id));
+    if (files.count() == m_FILE_BATCH_SIZE)
+    {
+        this->renameFiles(files);
+        files.clear();
+    }
+}
+
+void FileRenamer::renameDirectoriesPipelined(const QList<QDir> &directories)
+{
+    LOG_DEBUG("================");
+
+    m_renamePipeline.setRecursive(m_recursive);
+    m_renamePipeline.run(directories);
+
+    // Perform the renames still waiting in the journal.
+    if (m_renameJournal.hasPendingEntries())
+    {
+        this->commitJournalGroup();
+    }
+
+    foreach (const QString &pipeline_report_line, m_renamePipeline.report())
+    {
+        LOG_DEBUG(pipeline_report_line);
+    }
+
+    if (m_renamePipeline.directoryErrorCount() > 0)
+    {
+        LOG_WARNING("Cannot read " + QString::number(m_renamePipeline.directoryErrorCount()) + " directories");
+    }
+}
+
+bool FileRenamer::classifyFile(const QFileInfo &file, int &fileFilterId)
+{
+    fileFilterId = this->matchFilters(file);
+
+    return fileFilterId != FilterSet::NO_MATCH;
+}
+
+bool FileRenamer::extractTimestamp(const MatchedFile &file, NameTemplate::Timestamp &timestamp)
+{
+    ImageTimestamp image_timestamp = this->readImageTimestamp(file);
+    timestamp = image_timestamp.timestamp;
+
+    return image_timestamp.retVal == FileRename_Success;
+}
+
+void FileRenamer::commitFile(const QFileInfo &file, bool timestampExtracted, const NameTemplate::Timestamp &timestamp)
+{
+    if (this->isRenamedFile(file))
+    {
+        return;
+    }
+
+    // Increase the number of total files to rename.
+    m_totalFileCount++;
+
+    FileRename_RetVal ret_val = FileRename_Error;
+    if (timestampExtracted)
+    {
+        ret_val = this->commitRename(file, timestamp);
+    }
+    this->checkRenameResult(file, ret_val);
+}
+
+void FileRenamer::renameFiles(const MatchedFileList &files)
+{
+    if (m_jobCount > 1)
+    {
+        this->renameFilesParallel(files);
+    }
+    else
+    {
+        QElapsedTimer file_timer;
+        foreach (const MatchedFile &file, files)
+        {
+            LOG_DEBUG("----------------");
+
+            file_timer.start();
+            FileRename_RetVal ret_val = renameFile(file);
+            if (m_fileLatencyRecording && ret_val != FileRename_Skipped)
+            {
+                m_fileLatencies.append(file_timer.nsecsElapsed());
+            }
+            this->checkRenameResult(file.file, ret_val);
+        }
+    }
+
+    // Perform the renames still waiting in the journal.
+    if (m_renameJournal.hasPendingEntries())
+    {
+        this->commitJournalGroup();
+    }
+}
+
+void FileRenamer::renameFilesParallel(const MatchedFileList &matchedFiles)
+{
+    // Leave out the files this run produced before the workers read them.
+    MatchedFileList files;
+    files.reserve(matchedFiles.count());
+    foreach (const MatchedFile &file, matchedFiles)
+    {
+        if (!this->isRenamedFile(file.file))
+        {
+            files.append(file);
+        }
+    }
+
+    // Read the timestamps on the thread pool. The results are consumed in input order,
+    // so the renames are committed in exactly the same sequence as in the serial mode,
+    // while the workers keep reading ahead.
+    QThreadPool::globalInstance()->setMaxThreadCount(m_jobCount);
+    QFuture<ImageTimestamp> future = QtConcurrent::mapped(files, ImageTimestampReader(this));
+    QElapsedTimer file_timer;
+    for (int i = 0; i < files.count(); i++)
+    {
+        const QFileInfo &file = files.at(i).file;
+
+        // The latency of a file is what the commit loop spends on it: waiting for its timestamp and renaming it.
+        file_timer.start();
+
+        // Increase the number of total files to rename.
+        m_totalFileCount++;
+
+        ImageTimestamp image_timestamp = future.resultAt(i);
+        FileRename_RetVal ret_val = image_timestamp.retVal;
+        if (ret_val == FileRename_Success)
+        {
+            ret_val = this->commitRename(file, image_timestamp.timestamp);
+        }
+        if (m_fileLatencyRecording)
+        {
+            m_fileLatencies.append(file_timer.nsecsElapsed());
+        }
+        this->checkRenameResult(file, ret_val);
+    }
+}
+
+void FileRenamer::checkRenameResult(const QFileInfo &file, FileRename_RetVal retVal)
+{
+    switch (retVal)
+    {
+    case FileRename_Success:
+    case FileRename_Skipped:
+        break;
+    case FileRename_Error:
+    default:
+        LOG_WARNING("Cannot rename file: " + file.fileName());
+    }
+}
+
+FileRenamer::FileRename_RetVal FileRenamer::renameFile(const MatchedFile &file)
+{
+    if (this->isRenamedFile(file.file))
+    {
+        return FileRename_Skipped;
+    }
+
+    // Increase the number of total files to rename.
+    m_totalFileCount++;
+
+    ImageTimestamp image_timestamp = this->readImageTimestamp(file);
+    if (image_timestamp.retVal != FileRename_Success)
+    {
+        return image_timestamp.retVal;
+    }
+
+    return this->commitRename(file.file, image_timestamp.timestamp);
+}
+
+bool FileRenamer::isRenamedFile(const QFileInfo &file)
+{
+    // Directories are renamed while they are still being listed: a file renamed earlier in the run
+    // can show up again under its new name, which a filter may match as well.
+    if (!m_renamedFilePaths.contains(file.absoluteFilePath()))
+    {
+        return false;
+    }
+
+    LOG_DEBUG("File " + file.fileName() + " was renamed by this run, skipping...");
+
+    return true;
+}
+
+int FileRenamer::matchFilters(const QFileInfo &file)
+{
+    QString file_name = file.fileName();
+
+    LOG_DEBUG("Current file: " + file_name);
+
+    int file_filter_id;
+    {
+        RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_FilterMatch);
+        file_filter_id = m_fileFilters.match(file_name);
+    }
+    if (file_filter_id == FilterSet::NO_MATCH)
+    {
+        LOG_DEBUG("File " + file_name + " doesn't match any of the filters, skipping...");
+
+        return file_filter_id;
+    }
+
+    LOG_DEBUG("Matching filter: " + m_fileFilters.filterName(file_filter_id));
+
+    return file_filter_id;
+}
+
+FileRenamer::ImageTimestamp FileRenamer::readImageTimestamp(const MatchedFile &matchedFile)
+{
+    // Must stay safe to call from the worker threads. The shared state it touches is the filter set
+    // and the metadata cache lookups (read-only while renaming), the metadata cache inserts (under
+    // the cache mutex), the stage statistics (atomic counters), the XMP toolkit (under the lock it
+    // was initialized with) and the logging.
+    ImageTimestamp image_timestamp;
+    image_timestamp.retVal = FileRename_Error;
+
+    const QFileInfo &file = matchedFile.file;
+    QString file_name = file.fileName();
+
+    // Decode the timestamp from the file name if it holds one: when it is trusted there is no I/O at all.
+    int file_filter_id = matchedFile.fileFilterId;
+    NameTimestampDecoder::Mode name_timestamp_mode = m_fileFilters.nameTimestampMode(file_filter_id);
+    QString name_timestamp;
+    NameTemplate::Timestamp name_image_timestamp;
+    bool name_timestamp_valid = name_timestamp_mode != NameTimestampDecoder::Mode_Off &&
+                                NameTimestampDecoder::decode(m_fileFilters.nameTimestampDecoder(file_filter_id), file_name, name_timestamp) &&
+                                NameTemplate::parseTimestamp(name_timestamp, name_image_timestamp);
+    if (name_timestamp_valid && name_timestamp_mode == NameTimestampDecoder::Mode_First)
+    {
+        LOG_DEBUG("Image timestamp taken from the file name");
+
+        image_timestamp.timestamp = name_image_timestamp;
+        image_timestamp.source = MetadataCache::TimestampSource_FileName;
+        image_timestamp.retVal = FileRename_Success;
+
+        return image_timestamp;
+    }
+
+    // Check the metadata cache: a hit costs one stat and no file open.
+    // An entry that doesn't parse is a miss, and is replaced below.
+    MetadataCache::Key cache_key;
+    bool cache_key_valid = false;
+    bool cache_hit = false;
+    if (m_metadataCache.isOpen())
+    {
+        RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_CacheLookup);
+        QString cached_timestamp;
+        cache_key_valid = MetadataCache::makeKey(file, cache_key);
+        cache_hit = cache_key_valid && m_metadataCache.lookup(cache_key, cached_timestamp, image_timestamp.source) &&
+                    NameTemplate::parseTimestamp(cached_timestamp, image_timestamp.timestamp);
+    }
+    if (cache_hit)
+    {
+        LOG_DEBUG("Image timestamp found in the metadata cache");
+
+        image_timestamp.retVal = FileRename_Success;
+
+        return image_timestamp;
+    }
+
+    QString file_absolute_path = file.absoluteFilePath();
+    QString exif_data_value;
+    QString exif_data_sub_second;
+
+    // Sniff the format from the first bytes, so the file goes straight to the extractor that can read it.
+    ImageFormat::Format image_format = ImageFormat::Format_Unknown;
+    ExifReader::ExifRead_RetVal exif_read_ret_val = ExifReader::ExifRead_Unsupported;
+    {
+        QFile image_file(file_absolute_path);
+        if (image_file.open(QIODevice::ReadOnly))
+        {
+            image_format = ImageFormat::sniff(image_file.peek(ImageFormat::HEADER_SIZE));
+
+            // Try the fast JPEG path first, it reads nothing but the segment headers and the Exif block.
+            if (image_format == ImageFormat::Format_Jpeg)
+            {
+                RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_ExifRead);
+                exif_read_ret_val = ExifReader::readJpegDateTimeOriginal(image_file, exif_data_value, NULL, &exif_data_sub_second);
+            }
+        }
+    }
+    if (!ImageFormat::canCarryExif(image_format))
+    {
+        LOG_DEBUG("The image format cannot carry Exif data");
+
+        m_renameStatistics.countRoute(RenameStatistics::Route_NoExif);
+        exif_read_ret_val = ExifReader::ExifRead_NotFound;
+    }
+    else if (exif_read_ret_val != ExifReader::ExifRead_Unsupported)
+    {
+        m_renameStatistics.countRoute(RenameStatistics::Route_JpegFastPath);
+    }
+    else
+    {
+        LOG_DEBUG("Falling back to Exiv2...");
+
+        try
+        {
+            // Let Exiv2 read through a window rather than the whole file.
+            WindowedFileIo *windowed_file_io = new WindowedFileIo(file_absolute_path);
+            Exiv2::BasicIo::AutoPtr io(windowed_file_io);
+            Exiv2::Image::AutoPtr image;
+            {
+                RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_ImageOpen);
+
+                // Known formats skip the probing of every registered format.
+                switch (image_format)
+                {
+                case ImageFormat::Format_Jpeg:
+                    m_renameStatistics.countRoute(RenameStatistics::Route_Jpeg);
+                    image = Exiv2::newJpegInstance(io, false);
+                    break;
+                case ImageFormat::Format_Tiff:
+                    m_renameStatistics.countRoute(RenameStatistics::Route_Tiff);
+                    image = Exiv2::newTiffInstance(io, false);
+                    break;
+#ifdef EXV_HAVE_LIBZ
+                case ImageFormat::Format_Png:
+                    m_renameStatistics.countRoute(RenameStatistics::Route_Png);
+                    image = Exiv2::newPngInstance(io, false);
+                    break;
+#endif
+                default:
+                    m_renameStatistics.countRoute(RenameStatistics::Route_Probe);
+                    image = Exiv2::ImageFactory::open(io);
+                }
+            }
+            if (image.get() == NULL)
+            {
+                LOG_WARNING("Cannot load image: " + file_name);
+
+                return image_timestamp;
+            }
+
+            {
+                RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_ReadMetadata);
+                image->readMetadata();
+            }
+
+            LOG_DEBUG("Bytes read by Exiv2: " + QString::number(windowed_file_io->bytesRead()) + " (mapped: " + QString::number(windowed_file_io->bytesMapped()) + ")");
+
+            Exiv2::ExifData &exif_data = image->exifData();
+            Exiv2::ExifKey exif_key(m_IMAGE_TIMESTAMP_TAG.toStdString());
+            Exiv2::ExifData::const_iterator pos = exif_data.findKey(exif_key);
+            if (pos != exif_data.end())
+            {
+                exif_data_value = QString::fromStdString(pos->toString());
+                exif_read_ret_val = ExifReader::ExifRead_Found;
+
+                Exiv2::ExifData::const_iterator sub_second_pos = exif_data.findKey(Exiv2::ExifKey(m_IMAGE_SUB_SECOND_TAG.toStdString()));
+                if (sub_second_pos != exif_data.end())
+                {
+                    exif_data_sub_second = QString::fromStdString(sub_second_pos->toString());
+                }
+            }
+            else
+            {
+                exif_read_ret_val = ExifReader::ExifRead_NotFound;
+            }
+        }
+        catch (Exiv2::AnyError &e)
+        {
+            LOG_ERROR("Caught Exiv2 exception: " + QString(e.what()));
+
+            return image_timestamp;
+        }
+    }
+
+    // Cameras without a set clock write zeroes, or garbage: such a date is no better than none.
+    NameTemplate::Timestamp exif_data_image_timestamp;
+    bool exif_data_image_timestamp_valid = exif_read_ret_val == ExifReader::ExifRead_Found && NameTemplate::parseTimestamp(exif_data_value, exif_data_image_timestamp);
+    if (exif_read_ret_val == ExifReader::ExifRead_Found && !exif_data_image_timestamp_valid)
+    {
+        LOG_WARNING("Invalid image timestamp " + exif_data_value + ", ignoring it: " + file_name);
+    }
+
+    if (exif_data_image_timestamp_valid)
+    {
+        exif_data_image_timestamp.millisecond = NameTemplate::parseSubSecond(exif_data_sub_second);
+        image_timestamp.timestamp = exif_data_image_timestamp;
+        image_timestamp.source = MetadataCache::TimestampSource_Exif;
+
+        if (name_timestamp_valid)
+        {
+            QString exif_timestamp = NameTemplate::formatTimestamp(exif_data_image_timestamp);
+            if (name_timestamp != exif_timestamp.left(name_timestamp.length()))
+            {
+                LOG_WARNING("Image timestamp " + exif_timestamp + " differs from the file name one: " + name_timestamp);
+            }
+        }
+    }
+    else if (name_timestamp_valid)
+    {
+        LOG_DEBUG("No image timestamp, using the file name...");
+
+        image_timestamp.timestamp = name_image_timestamp;
+        image_timestamp.source = MetadataCache::TimestampSource_FileName;
+    }
+    else
+    {
+        LOG_DEBUG("No image timestamp, using file attributes...");
+
+        QDateTime image_file_last_modified_time = file.lastModified();
+        if (!image_file_last_modified_time.isValid())
+        {
+            LOG_WARNING("Cannot read the modification time of: " + file_name);
+
+            return image_timestamp;
+        }
+        QDate image_file_last_modified_date = image_file_last_modified_time.date();
+        QTime image_file_last_modified_clock_time = image_file_last_modified_time.time();
+        image_timestamp.timestamp.year = image_file_last_modified_date.year();
+        image_timestamp.timestamp.month = image_file_last_modified_date.month();
+        image_timestamp.timestamp.day = image_file_last_modified_date.day();
+        image_timestamp.timestamp.hour = image_file_last_modified_clock_time.hour();
+        image_timestamp.timestamp.minute = image_file_last_modified_clock_time.minute();
+        image_timestamp.timestamp.second = image_file_last_modified_clock_time.second();
+        image_timestamp.timestamp.millisecond = -1;
+        image_timestamp.source = MetadataCache::TimestampSource_FileTime;
+    }
+
+    if (cache_key_valid)
+    {
+        m_metadataCache.insert(cache_key, NameTemplate::formatTimestamp(image_timestamp.timestamp), image_timestamp.source);
+    }
+
+    image_timestamp.retVal = FileRename_Success;
+
+    return image_timestamp;
+}
+
+FileRenamer::FileRename_RetVal FileRenamer::commitRename(const QFileInfo &file, const NameTemplate::Timestamp &imageTimestamp)
+{
+    LOG_DEBUG("Image timestamp: " + NameTemplate::formatTimestamp(imageTimestamp));
+
+    NameTemplate::Timestamp current_image_timestamp = imageTimestamp;
+    QString file_suffix = file.completeSuffix();
+
+    // In archive mode the file goes straight to the bucket of its month, elsewhere it stays in its directory.
+    QDir target_directory(file.absoluteDir());
+    if (!m_archiveRootPath.isEmpty())
+    {
+        this->archiveDirectory(current_image_timestamp, target_directory);
+    }
+
+    // Try the image timestamp, then subsequent timestamps (or sequence numbers) for a minute.
+    // Shots of a burst share their second: when the sub-seconds are known, a taken name is first followed
+    // by the millisecond one, which depends on the image alone and not on the order the files come in.
+    // A template with {msec} puts the milliseconds in every name instead.
+    int millisecond_attempt = current_image_timestamp.millisecond != -1 && !m_nameTemplate.hasMillisecond() ? 1 : -1;
+    int attempt_count = millisecond_attempt != -1 ? 62 : 61;
+    int step = 0;
+    // The names are formatted into the buffer, and only copied into the string the reservation keeps:
+    // its storage is reused from one candidate to the next, until a reservation takes a share of it.
+    QChar new_image_name_buffer[NameTemplate::MAXIMUM_NAME_LENGTH];
+    QString new_image_name;
+    new_image_name.reserve(NameTemplate::MAXIMUM_NAME_LENGTH);
+    for (int i = 0; i < attempt_count; i++)
+    {
+        const NameTemplate *name_template = &m_nameTemplate;
+        int sequence = 0;
+        if (i == millisecond_attempt)
+        {
+            name_template = &m_millisecondNameTemplate;
+        }
+        else if (i > 0)
+        {
+            step++;
+            if (m_nameTemplate.hasSequence())
+            {
+                sequence = step;
+            }
+            else
+            {
+                NameTemplate::addSeconds(current_image_timestamp, 1);
+            }
+        }
+
+        int new_image_name_length = name_template->format(current_image_timestamp, sequence, file_suffix, new_image_name_buffer);
+        if (new_image_name_length == -1)
+        {
+            LOG_WARNING("New image name too long for: " + file.fileName());
+
+            return FileRename_Error;
+        }
+        new_image_name.setUnicode(new_image_name_buffer, new_image_name_length);
+
+        LOG_DEBUG("New image name: "+ new_image_name);
+
+        // A file already carrying this name is not a collision with itself: it stays as it is.
+        if (target_directory.filePath(new_image_name) == file.absoluteFilePath())
+        {
+            LOG_DEBUG("File " + file.fileName() + " already has its name, skipping...");
+
+            return FileRename_Skipped;
+        }
+
+        // Reserve the new name in the target directory.
+        bool new_image_name_reserved;
+        {
+            RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_NameProbe);
+            new_image_name_reserved = m_nameReservation.reserve(target_directory, new_image_name, m_renamePlan.isOpen() || m_renameJournal.isOpen());
+        }
+
+        // A name already on disk is refused by the kernel, and stays reserved so it isn't tried again.
+        AtomicRename::AtomicRename_RetVal ret_val = AtomicRename::AtomicRename_Exists;
+        if (new_image_name_reserved)
+        {
+            ret_val = this->performRename(file, target_directory, new_image_name);
+        }
+        if (ret_val == AtomicRename::AtomicRename_Success)
+        {
+            return FileRename_Success;
+        }
+        if (ret_val == AtomicRename::AtomicRename_Error)
+        {
+            return FileRename_Error;
+        }
+
+        // A name taken by a copy of this very file needs no further name.
+        if (m_duplicateAction != DuplicateCheck::Action_Off)
+        {
+            QString duplicate_file_path = target_directory.filePath(new_image_name);
+
+            // Linked by an earlier run: nothing is left to do, and it is not counted again.
+            if (m_duplicateAction == DuplicateCheck::Action_Link && DuplicateCheck::isSameFile(file.absoluteFilePath(), duplicate_file_path))
+            {
+                LOG_DEBUG("File " + file.fileName() + " is already linked to: " + duplicate_file_path);
+
+                return FileRename_Skipped;
+            }
+
+            if (DuplicateCheck::isDuplicate(file, duplicate_file_path))
+            {
+                return this->resolveDuplicate(file, duplicate_file_path);
+            }
+        }
+
+        if (i == 0)
+        {
+            LOG_WARNING("File " + new_image_name + " already exists");
+
+            LOG_DEBUG(millisecond_attempt != -1 ? "Trying with the milliseconds..." : "Trying with subsequent timestamps...");
+        }
+        else if (i == millisecond_attempt)
+        {
+            LOG_DEBUG("Trying with subsequent timestamps...");
+        }
+    }
+
+    return FileRename_Error;
+}
+
+void FileRenamer::archiveDirectory(const NameTemplate::Timestamp &timestamp, QDir &directory)
+{
+    // Only the path: the bucket is created when a file is actually moved to it.
+    directory.setPath(QString("%1/%2/%3")
+                      .arg(m_archiveRootPath)
+                      .arg(timestamp.year, 4, 10, QChar('0'))
+                      .arg(timestamp.month, 2, 10, QChar('0')));
+}
+
+bool FileRenamer::createTargetDirectory(const QString &targetFilePath)
+{
+    QString directory_path = QFileInfo(targetFilePath).absolutePath();
+
+    // Each directory is created the first time a file goes to it, and never checked on disk again.
+    if (!m_targetDirectoryPaths.contains(directory_path))
+    {
+        if (!QDir().mkpath(directory_path))
+        {
+            LOG_WARNING("Cannot create the directory: " + directory_path);
+
+            return false;
+        }
+        m_targetDirectoryPaths.insert(directory_path);
+    }
+
+    return true;
+}
+
+FileRenamer::FileRename_RetVal FileRenamer::resolveDuplicate(const QFileInfo &file, const QString &duplicateFilePath)
+{
+    LOG_DEBUG("File " + file.fileName() + " is a duplicate of: " + duplicateFilePath);
+
+    // A plan only records renames. Only the duplicates handled are counted, failures count against the exit status.
+    if (m_renamePlan.isOpen() || m_duplicateAction == DuplicateCheck::Action_Skip)
+    {
+        m_duplicateCount++;
+
+        return FileRename_Skipped;
+    }
+
+    if (m_duplicateAction == DuplicateCheck::Action_Link)
+    {
+        if (!this->journalDuplicate(file.absoluteFilePath(), duplicateFilePath, RenamePlan::Type_Link) || !DuplicateCheck::link(file.absoluteFilePath(), duplicateFilePath))
+        {
+            LOG_WARNING("Cannot link duplicate file: " + file.fileName());
+
+            return FileRename_Error;
+        }
+
+        m_duplicateCount++;
+
+        LOG_DEBUG("Duplicate file linked to: " + duplicateFilePath);
+
+        return FileRename_Success;
+    }
+
+    // Duplicates from different directories may share a name: a name taken in the quarantine gets a number.
+    // With a journal, the quarantine directory is listed once so taken names are known before they are logged.
+    QDir quarantine_directory(m_quarantineDirectoryPath);
+    if (!this->createTargetDirectory(quarantine_directory.filePath(file.fileName())))
+    {
+        return FileRename_Error;
+    }
+    QString quarantine_file_path;
+    for (int i = 0; ; i++)
+    {
+        QString quarantine_file_name = file.fileName();
+        if (i > 0)
+        {
+            quarantine_file_name = file.baseName() + " (" + QString::number(i) + ")";
+            if (!file.completeSuffix().isEmpty())
+            {
+                quarantine_file_name += "." + file.completeSuffix();
+            }
+        }
+        if (!m_nameReservation.reserve(quarantine_directory, quarantine_file_name, m_renameJournal.isOpen()))
+        {
+            continue;
+        }
+        quarantine_file_path = quarantine_directory.filePath(quarantine_file_name);
+
+        AtomicRename::AtomicRename_RetVal ret_val = AtomicRename::AtomicRename_Error;
+        if (this->journalDuplicate(file.absoluteFilePath(), quarantine_file_path, RenamePlan::Type_Rename))
+        {
+            ret_val = m_atomicRename.rename(file.absoluteFilePath(), quarantine_file_path);
+        }
+        if (ret_val == AtomicRename::AtomicRename_Success)
+        {
+            break;
+        }
+
+        // A name taken on disk stays reserved.
+        if (ret_val != AtomicRename::AtomicRename_Exists)
+        {
+            m_nameReservation.release(quarantine_directory, quarantine_file_name);
+
+            LOG_WARNING("Cannot move duplicate file to: " + quarantine_file_path);
+
+            return FileRename_Error;
+        }
+    }
+
+    // The old name is free again.
+    m_nameReservation.vacate(file.absoluteDir(), file.fileName());
+    m_duplicateCount++;
+
+    LOG_DEBUG("Duplicate file moved to: " + quarantine_file_path);
+
+    return FileRename_Success;
+}
+
+bool FileRenamer::journalDuplicate(const QString &from, const QString &to, RenamePlan::Type type)
+{
+    if (!m_renameJournal.isOpen())
+    {
+        return true;
+    }
+
+    // Duplicates are dealt with on the spot, not in groups: the renames queued before go first,
+    // so the journal keeps the order the changes are made in and --undo can reverse them all.
+    if (m_renameJournal.hasPendingEntries())
+    {
+        this->commitJournalGroup();
+    }
+    m_renameJournal.add(from, to, type);
+    QList<RenamePlan::Entry> entries;
+    if (!m_renameJournal.commit(entries))
+    {
+        LOG_ERROR("Cannot write to the rename journal: " + m_renameJournal.filePath());
+
+        return false;
+    }
+
+    return true;
+}
+
+AtomicRename::AtomicRename_RetVal FileRenamer::performRename(const QFileInfo &file, const QDir &directory, const QString &newImageName)
+{
+    QString new_image_file_name = directory.filePath(newImageName);
+
+    // In planning mode, record the rename instead of performing it.
+    if (m_renamePlan.isOpen())
+    {
+        if (!m_renamePlan.append(file.absoluteFilePath(), new_image_file_name))
+        {
+            m_nameReservation.release(directory, newImageName);
+
+            LOG_WARNING("Cannot write to the rename plan: " + m_renamePlan.filePath());
+
+            return AtomicRename::AtomicRename_Error;
+        }
+
+        // The plan is computed against the directory state after all the previous renames.
+        m_nameReservation.vacate(file.absoluteDir(), file.fileName(), true);
+
+        LOG_DEBUG("File planned to be renamed to: " + new_image_file_name);
+
+        m_renamedFileCount++;
+
+        return AtomicRename::AtomicRename_Success;
+    }
+
+    // With a journal, queue the rename: the whole group is logged and synced before it is performed.
+    if (m_renameJournal.isOpen())
+    {
+        m_renameJournal.add(file.absoluteFilePath(), new_image_file_name);
+        if (m_renameJournal.isGroupFull())
+        {
+            this->commitJournalGroup();
+        }
+
+        return AtomicRename::AtomicRename_Success;
+    }
+
+    // Rename the file, into its archive bucket if it goes to one.
+    AtomicRename::AtomicRename_RetVal ret_val = AtomicRename::AtomicRename_Error;
+    if (m_archiveRootPath.isEmpty() || this->createTargetDirectory(new_image_file_name))
+    {
+        RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_Rename);
+        ret_val = m_atomicRename.rename(file.absoluteFilePath(), new_image_file_name);
+    }
+    if (ret_val == AtomicRename::AtomicRename_Exists)
+    {
+        LOG_DEBUG("File " + newImageName + " already exists on disk");
+
+        return ret_val;
+    }
+    if (ret_val != AtomicRename::AtomicRename_Success)
+    {
+        m_nameReservation.release(directory, newImageName);
+
+        LOG_WARNING("Cannot rename file to: "+ newImageName);
+
+        return ret_val;
+    }
+
+    // The old name is free again.
+    m_nameReservation.vacate(file.absoluteDir(), file.fileName());
+    m_renamedFilePaths.insert(new_image_file_name);
+
+    LOG_DEBUG("File renamed to: " + new_image_file_name);
+
+    m_renamedFileCount++;
+
+    LOG_DEBUG("Files renamed: " + QString::number(m_renamedFileCount) + "/" + QString::number(m_totalFileCount));
+
+    return ret_val;
+}
+
+void FileRenamer::commitJournalGroup()
+{
+    QList<RenamePlan::Entry> entries;
+    bool committed = m_renameJournal.commit(entries);
+    if (!committed)
+    {
+        LOG_ERROR("Cannot write to the rename journal: " + m_renameJournal.filePath());
+    }
+
+    foreach (const RenamePlan::Entry &entry, entries)
+    {
+        QFileInfo from_file_info(entry.from);
+        QFileInfo to_file_info(entry.to);
+
+        // Renames that didn't make it to the journal are not performed.
+        AtomicRename::AtomicRename_RetVal ret_val = AtomicRename::AtomicRename_Error;
+        if (committed && (m_archiveRootPath.isEmpty() || this->createTargetDirectory(entry.to)))
+        {
+            RenameStatistics::StageTimer stage_timer(m_renameStatistics, RenameStatistics::Stage_Rename);
+            ret_val = m_atomicRename.rename(entry.from, entry.to);
+        }
+        if (ret_val != AtomicRename::AtomicRename_Success)
+        {
+            // A name taken on disk stays reserved.
+            if (ret_val != AtomicRename::AtomicRename_Exists)
+            {
+                m_nameReservation.release(to_file_info.absoluteDir(), to_file_info.fileName());
+            }
+
+            LOG_WARNING("Cannot rename file: " + from_file_info.fileName());
+
+            continue;
+        }
+
+        // The old name is free again.
+        m_nameReservation.vacate(from_file_info.absoluteDir(), from_file_info.fileName());
+        m_renamedFilePaths.insert(entry.to);
+
+        LOG_DEBUG("File renamed to: " + entry.to);
+
+        m_renamedFileCount++;
+    }
+
+    LOG_DEBUG("Files renamed: " + QString::number(m_renamedFileCount) + "/" + QString::number(m_totalFileCount));
 }
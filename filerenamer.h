@@ -4,15 +4,32 @@
 // Qt
 #include <QObject>
 #include <QDir>
+#include <QSet>
+#include <QVector>
 
 // Local
+#include "atomicrename.h"
 #include "base.h"
-class FileRenamer : public Base
+#include "duplicatecheck.h"
+#include "filterset.h"
+#include "matchedfile.h"
+#include "metadatacache.h"
+#include "namereservation.h"
+#include "nametemplate.h"
+#include "renamejournal.h"
+#include "renamepipeline.h"
+#include "renameplan.h"
+#include "renamestatistics.h"
+
+class FileRenamer : public Base, private RenamePipeline::Handler
 {
     Q_OBJECT
 
 private:
+    static const int m_FILE_BATCH_SIZE;
+    static const int m_FILE_LIST_CHUNK_SIZE;
     static const QString m_IMAGE_TIMESTAMP_TAG;
+    static const QString m_IMAGE_SUB_SECOND_TAG;
     static const QString m_TUMBLR_FILTER_1;
     static const QString m_TUMBLR_FILTER_2;
     static const QString m_TUMBLR_FILTER_3;
@@ -30,9 +47,36 @@ private:
         FileRename_Skipped,
         FileRename_Error
     };
-    QStringList m_fileFilters;
+    struct ImageTimestamp
+    {
+        FileRename_RetVal retVal;
+        NameTemplate::Timestamp timestamp;
+        MetadataCache::TimestampSource source;
+    };
+    class ImageTimestampReader;
+    FilterSet m_fileFilters;
     int m_totalFileCount;
     int m_renamedFileCount;
+    int m_jobCount;
+    NameReservation m_nameReservation;
+    NameTemplate m_nameTemplate;
+    NameTemplate m_millisecondNameTemplate;
+    RenamePlan m_renamePlan;
+    RenameJournal m_renameJournal;
+    MetadataCache m_metadataCache;
+    bool m_fileLatencyRecording;
+    QVector<qint64> m_fileLatencies;
+    RenameStatistics m_renameStatistics;
+    AtomicRename m_atomicRename;
+    bool m_recursive;
+    RenamePipeline m_renamePipeline;
+    bool m_pipelineEnabled;
+    DuplicateCheck::Action m_duplicateAction;
+    QString m_quarantineDirectoryPath;
+    int m_duplicateCount;
+    QString m_archiveRootPath;
+    QSet<QString> m_targetDirectoryPaths;
+    QSet<QString> m_renamedFilePaths;
 
 public:
     explicit FileRenamer(QObject *parent = NULL);
@@ -41,12 +85,64 @@ public:
 public:
     int totalFileCount() const;
     int renamedFileCount() const;
+    const FilterSet &fileFilters() const;
+    bool loadFilterRules(const QString &rulesFilePath);
+    int jobCount() const;
+    void setJobCount(int jobCount);
+    int nameLookupCount();
+    int nameDirectoryListingCount();
+    bool isRecursive() const;
+    void setRecursive(bool recursive);
+    bool isPipelineEnabled() const;
+    void setPipelineEnabled(bool pipelineEnabled);
+    void setPipelineThreadCount(RenamePipeline::Stage stage, int threadCount);
+    void setPipelineQueueCapacity(int queueCapacity);
+    bool setNameTemplate(const QString &nameTemplate);
+    bool setArchiveRoot(const QString &archiveRootPath);
+    bool setDuplicateAction(DuplicateCheck::Action duplicateAction, const QString &quarantineDirectoryPath = QString());
+    int duplicateCount() const;
+    bool setNameTimestampMode(const QString &filterName, NameTimestampDecoder::Mode nameTimestampMode);
     void processDirectories(const QList<QDir> &directories);
     void processFiles(const QFileInfoList &files);
+    void processFileList(QIODevice &fileList, char separator);
+    void setFileLatencyRecording(bool fileLatencyRecording);
+    const QVector<qint64> &fileLatencies() const;
+    void setStatisticsEnabled(bool statisticsEnabled);
+    QStringList statisticsReport() const;
+    bool openPlan(const QString &planFilePath);
+    void closePlan();
+    bool applyPlan(const QString &planFilePath);
+    bool openJournal(const QString &journalFilePath, bool append);
+    void closeJournal();
+    void setJournalGroupSize(int journalGroupSize);
+    bool openMetadataCache(const QString &cacheFilePath);
+    bool closeMetadataCache();
+    int journalSyncCount() const;
+    bool resumeJournal(const QString &journalFilePath);
+    bool undoJournal(const QString &journalFilePath);
 
 private:
-    void renameFiles(const QDir &directory);
-    FileRename_RetVal renameFile(const QFileInfo &file);
+    void renameDirectory(const QDir &directory);
+    void renameDirectoryTrees(const QList<QDir> &directories);
+    void renameDirectoriesPipelined(const QList<QDir> &directories);
+    virtual bool classifyFile(const QFileInfo &file, int &fileFilterId);
+    virtual bool extractTimestamp(const MatchedFile &file, NameTemplate::Timestamp &timestamp);
+    virtual void commitFile(const QFileInfo &file, bool timestampExtracted, const NameTemplate::Timestamp &timestamp);
+    void renameFiles(const MatchedFileList &files);
+    void appendListedFile(MatchedFileList &files, const QByteArray &filePath, char separator);
+    void renameFilesParallel(const MatchedFileList &matchedFiles);
+    void checkRenameResult(const QFileInfo &file, FileRename_RetVal retVal);
+    FileRename_RetVal renameFile(const MatchedFile &file);
+    bool isRenamedFile(const QFileInfo &file);
+    int matchFilters(const QFileInfo &file);
+    ImageTimestamp readImageTimestamp(const MatchedFile &matchedFile);
+    FileRename_RetVal commitRename(const QFileInfo &file, const NameTemplate::Timestamp &imageTimestamp);
+    void archiveDirectory(const NameTemplate::Timestamp &timestamp, QDir &directory);
+    bool createTargetDirectory(const QString &targetFilePath);
+    FileRename_RetVal resolveDuplicate(const QFileInfo &file, const QString &duplicateFilePath);
+    bool journalDuplicate(const QString &from, const QString &to, RenamePlan::Type type);
+    AtomicRename::AtomicRename_RetVal performRename(const QFileInfo &file, const QDir &directory, const QString &newImageName);
+    void commitJournalGroup();
 };
 
 #endif // FILERENAMER_H
@@ -0,0 +1,181 @@
+// Qt
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+// Local
+#include "filterrules.h"
+
+const QString FilterRules::m_NAME_KEY("name");
+const QString FilterRules::m_PATTERN_KEY("pattern");
+const QString FilterRules::m_DECODER_KEY("decoder");
+const QString FilterRules::m_CACHE_FILE_SUFFIX(".cache");
+const char FilterRules::m_MAGIC[8] = { 'M', 'F', 'R', 'R', 'U', 'L', 'E', 'S' };
+const quint32 FilterRules::m_VERSION(1);
+
+bool FilterRules::load(const QString &rulesFilePath, FilterSet &filterSet, QString *errorString, bool *cacheUsed)
+{
+    if (cacheUsed != NULL)
+    {
+        *cacheUsed = false;
+    }
+
+    QFile rules_file(rulesFilePath);
+    if (!rules_file.open(QIODevice::ReadOnly))
+    {
+        if (errorString != NULL)
+        {
+            *errorString = "Cannot open the filter rules: " + rulesFilePath;
+        }
+
+        return false;
+    }
+    QByteArray rules = rules_file.readAll();
+    rules_file.close();
+
+    int line_number = 0;
+    foreach (const QByteArray &line, rules.split('\n'))
+    {
+        line_number++;
+
+        QByteArray rule_line = line.trimmed();
+        if (rule_line.isEmpty() || rule_line.startsWith('#'))
+        {
+            continue;
+        }
+
+        Rule rule;
+        if (!FilterRules::parseRule(rule_line, rule))
+        {
+            if (errorString != NULL)
+            {
+                *errorString = QString("Invalid filter rule at %1:%2").arg(rulesFilePath).arg(line_number);
+            }
+
+            return false;
+        }
+        filterSet.addFilter(rule.name, rule.pattern, rule.decoder);
+    }
+
+    // The compiled form is only valid for the exact rules it was made from.
+    QByteArray rules_hash = QCryptographicHash::hash(rules, QCryptographicHash::Sha1);
+    if (FilterRules::loadCache(rulesFilePath, rules_hash, filterSet))
+    {
+        if (cacheUsed != NULL)
+        {
+            *cacheUsed = true;
+        }
+
+        return true;
+    }
+
+    if (!filterSet.compile(errorString))
+    {
+        return false;
+    }
+
+    // Not being able to write the cache only costs the next start some time.
+    FilterRules::saveCache(rulesFilePath, rules_hash, filterSet);
+
+    return true;
+}
+
+QString FilterRules::cacheFilePath(const QString &rulesFilePath)
+{
+    return rulesFilePath + m_CACHE_FILE_SUFFIX;
+}
+
+QByteArray FilterRules::formatRule(const Rule &rule)
+{
+    QJsonObject json_object;
+    json_object.insert(m_NAME_KEY, rule.name);
+    json_object.insert(m_PATTERN_KEY, rule.pattern);
+    if (rule.decoder == NameTimestampDecoder::Decoder_DateTime)
+    {
+        json_object.insert(m_DECODER_KEY, QString("datetime"));
+    }
+    else if (rule.decoder == NameTimestampDecoder::Decoder_EpochMilliseconds)
+    {
+        json_object.insert(m_DECODER_KEY, QString("epoch-ms"));
+    }
+
+    return QJsonDocument(json_object).toJson(QJsonDocument::Compact);
+}
+
+bool FilterRules::parseRule(const QByteArray &line, Rule &rule)
+{
+    QJsonDocument json_document = QJsonDocument::fromJson(line);
+    if (!json_document.isObject())
+    {
+        return false;
+    }
+
+    QJsonObject json_object = json_document.object();
+    rule.name = json_object.value(m_NAME_KEY).toString();
+    rule.pattern = json_object.value(m_PATTERN_KEY).toString();
+    if (!NameTimestampDecoder::parseDecoder(json_object.value(m_DECODER_KEY).toString(), rule.decoder))
+    {
+        return false;
+    }
+
+    return !rule.name.isEmpty() && !rule.pattern.isEmpty();
+}
+
+bool FilterRules::loadCache(const QString &rulesFilePath, const QByteArray &rulesHash, FilterSet &filterSet)
+{
+    QFile cache_file(FilterRules::cacheFilePath(rulesFilePath));
+    if (!cache_file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QByteArray magic = cache_file.read(sizeof(m_MAGIC));
+    if (magic != QByteArray(m_MAGIC, sizeof(m_MAGIC)))
+    {
+        return false;
+    }
+
+    QDataStream data_stream(&cache_file);
+    data_stream.setVersion(QDataStream::Qt_5_5);
+    quint32 version = 0;
+    QByteArray rules_hash;
+    QString combined_pattern;
+    QList<int> filter_capture_groups;
+    data_stream >> version;
+    if (version != m_VERSION)
+    {
+        return false;
+    }
+    data_stream >> rules_hash >> combined_pattern >> filter_capture_groups;
+    if (data_stream.status() != QDataStream::Ok || rules_hash != rulesHash)
+    {
+        return false;
+    }
+
+    return filterSet.restore(combined_pattern, filter_capture_groups);
+}
+
+bool FilterRules::saveCache(const QString &rulesFilePath, const QByteArray &rulesHash, const FilterSet &filterSet)
+{
+    QSaveFile save_file(FilterRules::cacheFilePath(rulesFilePath));
+    if (!save_file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    save_file.write(m_MAGIC, sizeof(m_MAGIC));
+    QDataStream data_stream(&save_file);
+    data_stream.setVersion(QDataStream::Qt_5_5);
+    data_stream << m_VERSION << rulesHash << filterSet.combinedPattern() << filterSet.filterCaptureGroups();
+    if (data_stream.status() != QDataStream::Ok)
+    {
+        save_file.cancelWriting();
+
+        return false;
+    }
+
+    return save_file.commit();
+}
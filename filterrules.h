@@ -0,0 +1,44 @@
+#ifndef FILTERRULES_H
+#define FILTERRULES_H
+
+// Qt
+#include <QByteArray>
+#include <QString>
+
+// Local
+#include "filterset.h"
+
+// Filter rules file: one JSON object per line, {"name": "<filter name>", "pattern": "<expression>", "decoder": "datetime" | "epoch-ms"},
+// the decoder being optional. Blank lines and lines starting with # are skipped.
+// The rules are compiled into a single filter set, and the compiled form is kept next to the rules file,
+// so a later start with the same rules skips checking and compiling every rule on its own.
+class FilterRules
+{
+public:
+    struct Rule
+    {
+        QString name;
+        QString pattern;
+        NameTimestampDecoder::Decoder decoder;
+    };
+
+private:
+    static const QString m_NAME_KEY;
+    static const QString m_PATTERN_KEY;
+    static const QString m_DECODER_KEY;
+    static const QString m_CACHE_FILE_SUFFIX;
+    static const char m_MAGIC[8];
+    static const quint32 m_VERSION;
+
+public:
+    static bool load(const QString &rulesFilePath, FilterSet &filterSet, QString *errorString = NULL, bool *cacheUsed = NULL);
+    static QString cacheFilePath(const QString &rulesFilePath);
+    static QByteArray formatRule(const Rule &rule);
+    static bool parseRule(const QByteArray &line, Rule &rule);
+
+private:
+    static bool loadCache(const QString &rulesFilePath, const QByteArray &rulesHash, FilterSet &filterSet);
+    static bool saveCache(const QString &rulesFilePath, const QByteArray &rulesHash, const FilterSet &filterSet);
+};
+
+#endif // FILTERRULES_H
@@ -0,0 +1,784 @@
+// Local
+#include "filterset.h"
+
+const int FilterSet::NO_MATCH(-1);
+const int FilterSet::m_MAXIMUM_SCANNED_LENGTH(65536);
+
+FilterSet::Prefilter::Prefilter() :
+    minimumLength(0),
+    maximumLength(-1),
+    extensions(),
+    prefix(),
+    substring()
+{
+}
+
+FilterSet::Prefilter::Prefilter(int minimumLength, int maximumLength, const QStringList &extensions, const QString &prefix, const QString &substring) :
+    minimumLength(minimumLength),
+    maximumLength(maximumLength),
+    extensions(extensions),
+    prefix(prefix),
+    substring(substring)
+{
+}
+
+FilterSet::FilterSet() :
+    m_filterNames(),
+    m_filterPatterns(),
+    m_filterCaptureGroups(),
+    m_nameTimestampDecoders(),
+    m_nameTimestampModes(),
+    m_prefilters(),
+    m_prefiltered(),
+    m_prefilterExtensions(),
+    m_allPrefiltered(false),
+    m_regularExpression(),
+    m_compiled(false)
+{
+}
+
+int FilterSet::addFilter(const QString &filterName, const QString &filterPattern, NameTimestampDecoder::Decoder nameTimestampDecoder)
+{
+    m_filterNames.append(filterName);
+    m_filterPatterns.append(filterPattern);
+
+    // A timestamp in the name is only used once --name-timestamp asks for it: by default the metadata decides.
+    m_nameTimestampDecoders.append(nameTimestampDecoder);
+    m_nameTimestampModes.append(NameTimestampDecoder::Mode_Off);
+
+    // Until one is set, the prefilter is what the expression itself states; if that is nothing,
+    // the filter lets every name through to the expression.
+    Prefilter prefilter = FilterSet::derivePrefilter(filterPattern);
+    m_prefilters.append(prefilter);
+    m_prefiltered.append(prefilter.minimumLength > 0 || prefilter.maximumLength != -1 || !prefilter.prefix.isEmpty());
+    this->updatePrefilters();
+
+    // Adding a filter invalidates the compiled expression.
+    m_compiled = false;
+
+    return m_filterNames.count() - 1;
+}
+
+bool FilterSet::compile(QString *errorString)
+{
+    m_filterCaptureGroups.clear();
+    m_compiled = false;
+
+    // Build the combined expression: each filter becomes one alternative of an anchored group.
+    // Inline options such as (?i) only apply up to the end of the group they appear in,
+    // so wrapping every filter in its own group keeps them from leaking into the next one.
+    QString combined_pattern("^(?:");
+    int capture_group = 1;
+    for (int i = 0; i < m_filterPatterns.count(); i++)
+    {
+        QString filter_pattern = FilterSet::stripAnchors(m_filterPatterns.at(i));
+        QRegularExpression filter_regular_expression(filter_pattern);
+        if (!filter_regular_expression.isValid())
+        {
+            if (errorString != NULL)
+            {
+                *errorString = "Invalid filter " + m_filterNames.at(i) + ": " + filter_regular_expression.errorString();
+            }
+
+            return false;
+        }
+
+        if (i > 0)
+        {
+            combined_pattern += "|";
+        }
+        combined_pattern += "(" + filter_pattern + ")";
+
+        // The wrapping group comes first, followed by the groups of the filter itself.
+        m_filterCaptureGroups.append(capture_group);
+        capture_group += 1 + filter_regular_expression.captureCount();
+    }
+    combined_pattern += ")$";
+
+    m_regularExpression.setPattern(combined_pattern);
+    if (!m_regularExpression.isValid())
+    {
+        if (errorString != NULL)
+        {
+            *errorString = "Invalid filter set: " + m_regularExpression.errorString();
+        }
+
+        return false;
+    }
+
+    // Compile (and JIT) the expression now rather than on the first match.
+    m_regularExpression.optimize();
+
+    m_compiled = true;
+
+    return true;
+}
+
+bool FilterSet::restore(const QString &combinedPattern, const QList<int> &filterCaptureGroups, QString *errorString)
+{
+    m_filterCaptureGroups.clear();
+    m_compiled = false;
+
+    // The result of an earlier compile of the same filters: the filters themselves need no checking again.
+    if (filterCaptureGroups.count() != m_filterPatterns.count())
+    {
+        if (errorString != NULL)
+        {
+            *errorString = "The compiled filter set doesn't match the filters";
+        }
+
+        return false;
+    }
+
+    m_regularExpression.setPattern(combinedPattern);
+    if (!m_regularExpression.isValid())
+    {
+        if (errorString != NULL)
+        {
+            *errorString = "Invalid filter set: " + m_regularExpression.errorString();
+        }
+
+        return false;
+    }
+    m_regularExpression.optimize();
+    m_filterCaptureGroups = filterCaptureGroups;
+
+    m_compiled = true;
+
+    return true;
+}
+
+QString FilterSet::combinedPattern() const
+{
+    return m_regularExpression.pattern();
+}
+
+QList<int> FilterSet::filterCaptureGroups() const
+{
+    return m_filterCaptureGroups;
+}
+
+bool FilterSet::isCompiled() const
+{
+    return m_compiled;
+}
+
+int FilterSet::count() const
+{
+    return m_filterNames.count();
+}
+
+QString FilterSet::filterName(int filterId) const
+{
+    return m_filterNames.value(filterId);
+}
+
+QString FilterSet::filterPattern(int filterId) const
+{
+    return m_filterPatterns.value(filterId);
+}
+
+int FilterSet::filterId(const QString &filterName) const
+{
+    return m_filterNames.indexOf(filterName);
+}
+
+NameTimestampDecoder::Decoder FilterSet::nameTimestampDecoder(int filterId) const
+{
+    return m_nameTimestampDecoders.value(filterId, NameTimestampDecoder::Decoder_None);
+}
+
+NameTimestampDecoder::Mode FilterSet::nameTimestampMode(int filterId) const
+{
+    return m_nameTimestampModes.value(filterId, NameTimestampDecoder::Mode_Off);
+}
+
+void FilterSet::setNameTimestampMode(int filterId, NameTimestampDecoder::Mode nameTimestampMode)
+{
+    if (filterId < 0 || filterId >= m_nameTimestampModes.count())
+    {
+        return;
+    }
+
+    // Without a decoder there is nothing to use.
+    if (m_nameTimestampDecoders.at(filterId) == NameTimestampDecoder::Decoder_None)
+    {
+        return;
+    }
+
+    m_nameTimestampModes[filterId] = nameTimestampMode;
+}
+
+void FilterSet::setPrefilter(int filterId, const Prefilter &prefilter)
+{
+    if (filterId < 0 || filterId >= m_prefilters.count())
+    {
+        return;
+    }
+
+    m_prefilters[filterId] = prefilter;
+    m_prefiltered[filterId] = true;
+    this->updatePrefilters();
+}
+
+int FilterSet::match(const QString &fileName) const
+{
+    if (!m_compiled)
+    {
+        return NO_MATCH;
+    }
+
+    if (m_allPrefiltered && !this->passesPrefilters(fileName))
+    {
+        return NO_MATCH;
+    }
+
+    QRegularExpressionMatch regular_expression_match = m_regularExpression.match(fileName);
+    if (!regular_expression_match.hasMatch())
+    {
+        return NO_MATCH;
+    }
+
+    // Find which alternative matched.
+    for (int i = 0; i < m_filterCaptureGroups.count(); i++)
+    {
+        if (regular_expression_match.capturedStart(m_filterCaptureGroups.at(i)) != -1)
+        {
+            return i;
+        }
+    }
+
+    return NO_MATCH;
+}
+
+bool FilterSet::passesPrefilters(const QString &fileName) const
+{
+    int extension_index = fileName.lastIndexOf('.');
+    QString extension = extension_index != -1 ? fileName.mid(extension_index + 1).toLower() : QString();
+    if (!m_prefilterExtensions.isEmpty() && !m_prefilterExtensions.contains(extension))
+    {
+        return false;
+    }
+
+    foreach (const Prefilter &prefilter, m_prefilters)
+    {
+        if (FilterSet::passesPrefilter(prefilter, fileName, extension))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FilterSet::passesPrefilter(const Prefilter &prefilter, const QString &fileName, const QString &extension)
+{
+    if (fileName.length() < prefilter.minimumLength || (prefilter.maximumLength != -1 && fileName.length() > prefilter.maximumLength))
+    {
+        return false;
+    }
+    if (!prefilter.extensions.isEmpty() && !prefilter.extensions.contains(extension, Qt::CaseInsensitive))
+    {
+        return false;
+    }
+    if (!prefilter.prefix.isEmpty() && !fileName.startsWith(prefilter.prefix))
+    {
+        return false;
+    }
+    if (!prefilter.substring.isEmpty() && !fileName.contains(prefilter.substring))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+QString FilterSet::stripAnchors(const QString &filterPattern)
+{
+    // Filters are written as full-name expressions; the combined expression provides the anchors.
+    QString filter_pattern(filterPattern);
+    if (filter_pattern.startsWith('^'))
+    {
+        filter_pattern.remove(0, 1);
+    }
+    if (filter_pattern.endsWith('$') && !filter_pattern.endsWith("\\$"))
+    {
+        filter_pattern.chop(1);
+    }
+
+    return filter_pattern;
+}
+
+void FilterSet::updatePrefilters()
+{
+    // Gather the extensions of all the filters, so most names are rejected with one lookup.
+    m_allPrefiltered = !m_prefiltered.contains(false);
+    m_prefilterExtensions.clear();
+    foreach (const Prefilter &filter_prefilter, m_prefilters)
+    {
+        if (filter_prefilter.extensions.isEmpty())
+        {
+            m_prefilterExtensions.clear();
+
+            break;
+        }
+        foreach (const QString &extension, filter_prefilter.extensions)
+        {
+            m_prefilterExtensions.insert(extension.toLower());
+        }
+    }
+}
+
+FilterSet::Prefilter FilterSet::derivePrefilter(const QString &filterPattern)
+{
+    // The length an expression can match and the literal text it starts with, read off the pattern.
+    // Lengths are in UTF-16 code units, like the names: anything but a literal may match a surrogate pair.
+    // A construct the scan doesn't know (back references, recursion, extended mode...) leaves the filter open.
+    QString pattern = FilterSet::stripAnchors(filterPattern);
+    int position = 0;
+    int minimum_length = 0;
+    int maximum_length = 0;
+    QString prefix;
+    if (!FilterSet::scanAlternatives(pattern, position, minimum_length, maximum_length, &prefix) || position != pattern.length())
+    {
+        return Prefilter();
+    }
+
+    // The closing $ of the combined expression also matches before a final newline.
+    return Prefilter(qMax(minimum_length, 0), FilterSet::addLength(maximum_length, 1), QStringList(), prefix);
+}
+
+bool FilterSet::scanAlternatives(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString *prefix)
+{
+    bool first_alternative = true;
+    forever
+    {
+        int alternative_minimum_length = 0;
+        int alternative_maximum_length = 0;
+        if (!FilterSet::scanSequence(pattern, position, alternative_minimum_length, alternative_maximum_length, prefix))
+        {
+            return false;
+        }
+
+        if (first_alternative)
+        {
+            minimumLength = alternative_minimum_length;
+            maximumLength = alternative_maximum_length;
+            first_alternative = false;
+        }
+        else
+        {
+            // A minimum of -1 is past any name, so the smaller one is the other.
+            minimumLength = minimumLength == -1 ? alternative_minimum_length : (alternative_minimum_length == -1 ? minimumLength : qMin(minimumLength, alternative_minimum_length));
+            maximumLength = maximumLength == -1 || alternative_maximum_length == -1 ? -1 : qMax(maximumLength, alternative_maximum_length);
+        }
+
+        if (position >= pattern.length() || pattern.at(position) != '|')
+        {
+            return true;
+        }
+        position++;
+
+        // Names starting with another alternative have no common prefix.
+        if (prefix != NULL)
+        {
+            prefix->clear();
+            prefix = NULL;
+        }
+    }
+}
+
+bool FilterSet::scanSequence(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString *prefix)
+{
+    minimumLength = 0;
+    maximumLength = 0;
+    while (position < pattern.length() && pattern.at(position) != '|' && pattern.at(position) != ')')
+    {
+        int atom_minimum_length = 0;
+        int atom_maximum_length = 0;
+        QString literal;
+        if (!FilterSet::scanAtom(pattern, position, atom_minimum_length, atom_maximum_length, literal))
+        {
+            return false;
+        }
+        int minimum_count = 1;
+        int maximum_count = 1;
+        FilterSet::scanQuantifier(pattern, position, minimum_count, maximum_count);
+
+        // The prefix runs up to the first atom that isn't one literal character, matched at least once.
+        if (prefix != NULL)
+        {
+            if (!literal.isEmpty() && minimum_count > 0)
+            {
+                prefix->append(literal);
+            }
+            if (literal.isEmpty() || minimum_count != 1 || maximum_count != 1)
+            {
+                prefix = NULL;
+            }
+        }
+
+        minimumLength = FilterSet::addLength(minimumLength, FilterSet::multiplyLength(atom_minimum_length, minimum_count));
+        maximumLength = FilterSet::addLength(maximumLength, FilterSet::multiplyLength(atom_maximum_length, maximum_count));
+    }
+
+    return true;
+}
+
+bool FilterSet::scanAtom(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString &literal)
+{
+    QChar character = pattern.at(position);
+    position++;
+    switch (character.unicode())
+    {
+    case '(':
+        return FilterSet::scanGroup(pattern, position, minimumLength, maximumLength);
+    case '[':
+        minimumLength = 1;
+        maximumLength = 2;
+        return FilterSet::scanClass(pattern, position);
+    case '\\':
+        return FilterSet::scanEscape(pattern, position, minimumLength, maximumLength, literal);
+    case '^':
+    case '$':
+        minimumLength = 0;
+        maximumLength = 0;
+        return true;
+    case '.':
+        minimumLength = 1;
+        maximumLength = 2;
+        return true;
+    case '*':
+    case '+':
+    case '?':
+        return false;
+    default:
+        break;
+    }
+
+    literal = character;
+    if (character.isHighSurrogate() && position < pattern.length() && pattern.at(position).isLowSurrogate())
+    {
+        literal += pattern.at(position);
+        position++;
+    }
+    minimumLength = literal.length();
+    maximumLength = literal.length();
+
+    return true;
+}
+
+bool FilterSet::scanGroup(const QString &pattern, int &position, int &minimumLength, int &maximumLength)
+{
+    bool zero_width = false;
+    if (position < pattern.length() && pattern.at(position) == '?')
+    {
+        position++;
+        if (position >= pattern.length())
+        {
+            return false;
+        }
+
+        QChar kind = pattern.at(position);
+        QChar next = position + 1 < pattern.length() ? pattern.at(position + 1) : QChar();
+        if (kind == ':' || kind == '>' || kind == '|')
+        {
+            position++;
+        }
+        else if (kind == '=' || kind == '!')
+        {
+            position++;
+            zero_width = true;
+        }
+        else if (kind == '<' && (next == '=' || next == '!'))
+        {
+            position += 2;
+            zero_width = true;
+        }
+        else if (kind == '<' || kind == '\'' || (kind == 'P' && next == '<'))
+        {
+            // Named groups match like any other.
+            int name_end = pattern.indexOf(kind == '\'' ? '\'' : '>', position + (kind == 'P' ? 2 : 1));
+            if (name_end == -1)
+            {
+                return false;
+            }
+            position = name_end + 1;
+        }
+        else if (kind == '#')
+        {
+            int comment_end = pattern.indexOf(')', position);
+            if (comment_end == -1)
+            {
+                return false;
+            }
+            position = comment_end + 1;
+            minimumLength = 0;
+            maximumLength = 0;
+
+            return true;
+        }
+        else
+        {
+            // Inline options, for the rest of the enclosing group or for the group they open.
+            // Extended mode changes what every later character means.
+            static const QString options("imnsJU-");
+            while (position < pattern.length() && options.contains(pattern.at(position)))
+            {
+                position++;
+            }
+            if (position >= pattern.length())
+            {
+                return false;
+            }
+            if (pattern.at(position) == ')')
+            {
+                position++;
+                minimumLength = 0;
+                maximumLength = 0;
+
+                return true;
+            }
+            if (pattern.at(position) != ':')
+            {
+                return false;
+            }
+            position++;
+        }
+    }
+
+    if (!FilterSet::scanAlternatives(pattern, position, minimumLength, maximumLength, NULL))
+    {
+        return false;
+    }
+    if (position >= pattern.length() || pattern.at(position) != ')')
+    {
+        return false;
+    }
+    position++;
+
+    if (zero_width)
+    {
+        minimumLength = 0;
+        maximumLength = 0;
+    }
+
+    return true;
+}
+
+bool FilterSet::scanClass(const QString &pattern, int &position)
+{
+    // A ] right after the opening (or after its ^) is part of the class.
+    if (position < pattern.length() && pattern.at(position) == '^')
+    {
+        position++;
+    }
+    if (position < pattern.length() && pattern.at(position) == ']')
+    {
+        position++;
+    }
+
+    while (position < pattern.length() && pattern.at(position) != ']')
+    {
+        if (pattern.at(position) == '\\')
+        {
+            position += 2;
+        }
+        else if (pattern.midRef(position, 2) == QLatin1String("[:"))
+        {
+            int name_end = pattern.indexOf(":]", position + 2);
+            if (name_end == -1)
+            {
+                return false;
+            }
+            position = name_end + 2;
+        }
+        else
+        {
+            position++;
+        }
+    }
+    if (position >= pattern.length())
+    {
+        return false;
+    }
+    position++;
+
+    return true;
+}
+
+bool FilterSet::scanEscape(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString &literal)
+{
+    if (position >= pattern.length())
+    {
+        return false;
+    }
+
+    QChar character = pattern.at(position);
+    position++;
+    if (!character.isLetterOrNumber())
+    {
+        // An escaped symbol stands for itself.
+        literal = character;
+        minimumLength = 1;
+        maximumLength = 1;
+
+        return true;
+    }
+
+    minimumLength = 1;
+    maximumLength = 2;
+    switch (character.unicode())
+    {
+    case 'b':
+    case 'B':
+    case 'A':
+    case 'z':
+    case 'Z':
+    case 'G':
+    case 'K':
+    case 'E':
+        minimumLength = 0;
+        maximumLength = 0;
+        return true;
+    case 'd':
+    case 'D':
+    case 'w':
+    case 'W':
+    case 's':
+    case 'S':
+    case 'h':
+    case 'H':
+    case 'v':
+    case 'V':
+    case 'N':
+    case 'a':
+    case 'e':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+        return true;
+    case 'R':
+        maximumLength = 4;
+        return true;
+    case 'X':
+        maximumLength = -1;
+        return true;
+    case 'c':
+        position++;
+        return position <= pattern.length();
+    case 'p':
+    case 'P':
+    case 'x':
+        if (position < pattern.length() && pattern.at(position) == '{')
+        {
+            int brace_end = pattern.indexOf('}', position);
+            if (brace_end == -1)
+            {
+                return false;
+            }
+            position = brace_end + 1;
+        }
+        else if (character == 'x')
+        {
+            // Up to two hexadecimal digits.
+            static const QString hexadecimal_digits("0123456789abcdefABCDEF");
+            for (int i = 0; i < 2 && position < pattern.length() && hexadecimal_digits.contains(pattern.at(position)); i++)
+            {
+                position++;
+            }
+        }
+        else
+        {
+            position++;
+        }
+        return position <= pattern.length();
+    default:
+        // Back references, octal codes, quoting...
+        return false;
+    }
+}
+
+void FilterSet::scanQuantifier(const QString &pattern, int &position, int &minimumCount, int &maximumCount)
+{
+    minimumCount = 1;
+    maximumCount = 1;
+    if (position >= pattern.length())
+    {
+        return;
+    }
+
+    QChar character = pattern.at(position);
+    if (character == '*' || character == '+' || character == '?')
+    {
+        minimumCount = character == '+' ? 1 : 0;
+        maximumCount = character == '?' ? 1 : -1;
+        position++;
+    }
+    else if (character == '{')
+    {
+        // A brace that isn't {n}, {n,} or {n,m} is a literal one.
+        int brace_end = pattern.indexOf('}', position);
+        if (brace_end == -1)
+        {
+            return;
+        }
+        QStringList bounds = pattern.mid(position + 1, brace_end - position - 1).split(',');
+        if (bounds.count() > 2 || bounds.first().isEmpty())
+        {
+            return;
+        }
+        foreach (const QString &bound, bounds)
+        {
+            foreach (const QChar &bound_character, bound)
+            {
+                if (!bound_character.isDigit() || bound_character.unicode() > '9')
+                {
+                    return;
+                }
+            }
+        }
+
+        minimumCount = qMin(bounds.first().toInt(), m_MAXIMUM_SCANNED_LENGTH);
+        maximumCount = bounds.count() == 1 ? minimumCount : (bounds.last().isEmpty() ? -1 : qMin(bounds.last().toInt(), m_MAXIMUM_SCANNED_LENGTH));
+        position = brace_end + 1;
+    }
+    else
+    {
+        return;
+    }
+
+    // Lazy and possessive forms repeat just as often.
+    if (position < pattern.length() && (pattern.at(position) == '?' || pattern.at(position) == '+'))
+    {
+        position++;
+    }
+}
+
+int FilterSet::addLength(int length, int addedLength)
+{
+    // -1 is no bound; so is a length past any file name's.
+    if (length == -1 || addedLength == -1)
+    {
+        return -1;
+    }
+    qint64 total_length = qint64(length) + addedLength;
+
+    return total_length > m_MAXIMUM_SCANNED_LENGTH ? -1 : int(total_length);
+}
+
+int FilterSet::multiplyLength(int length, int count)
+{
+    if (length == 0 || count == 0)
+    {
+        return 0;
+    }
+    if (length == -1 || count == -1)
+    {
+        return -1;
+    }
+    qint64 total_length = qint64(length) * count;
+
+    return total_length > m_MAXIMUM_SCANNED_LENGTH ? -1 : int(total_length);
+}
@@ -0,0 +1,87 @@
+#ifndef FILTERSET_H
+#define FILTERSET_H
+
+// Qt
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QRegularExpression>
+
+// Local
+#include "nametimestampdecoder.h"
+
+// Matches file names against a set of filters compiled into a single regular expression.
+// Each filter is wrapped in its own capture group, so one match call returns the id of the filter that matched.
+// A filter whose names encode the capture time also carries the decoder for it, and when to use it.
+// Filters may also state literal facts every name they match satisfies (length, extension, prefix, substring),
+// and a filter that doesn't gets the length and prefix its own expression spells out:
+// when every filter has such facts, names failing all of them are rejected without running the expression.
+class FilterSet
+{
+public:
+    static const int NO_MATCH;
+    struct Prefilter
+    {
+        int minimumLength;
+        int maximumLength;
+        QStringList extensions;
+        QString prefix;
+        QString substring;
+
+        Prefilter();
+        Prefilter(int minimumLength, int maximumLength, const QStringList &extensions, const QString &prefix = QString(), const QString &substring = QString());
+    };
+
+private:
+    static const int m_MAXIMUM_SCANNED_LENGTH;
+    QStringList m_filterNames;
+    QStringList m_filterPatterns;
+    QList<int> m_filterCaptureGroups;
+    QList<NameTimestampDecoder::Decoder> m_nameTimestampDecoders;
+    QList<NameTimestampDecoder::Mode> m_nameTimestampModes;
+    QList<Prefilter> m_prefilters;
+    QList<bool> m_prefiltered;
+    QSet<QString> m_prefilterExtensions;
+    bool m_allPrefiltered;
+    QRegularExpression m_regularExpression;
+    bool m_compiled;
+
+public:
+    FilterSet();
+
+public:
+    int addFilter(const QString &filterName, const QString &filterPattern, NameTimestampDecoder::Decoder nameTimestampDecoder = NameTimestampDecoder::Decoder_None);
+    bool compile(QString *errorString = NULL);
+    bool restore(const QString &combinedPattern, const QList<int> &filterCaptureGroups, QString *errorString = NULL);
+    QString combinedPattern() const;
+    QList<int> filterCaptureGroups() const;
+    bool isCompiled() const;
+    int count() const;
+    QString filterName(int filterId) const;
+    QString filterPattern(int filterId) const;
+    int filterId(const QString &filterName) const;
+    NameTimestampDecoder::Decoder nameTimestampDecoder(int filterId) const;
+    NameTimestampDecoder::Mode nameTimestampMode(int filterId) const;
+    void setNameTimestampMode(int filterId, NameTimestampDecoder::Mode nameTimestampMode);
+    void setPrefilter(int filterId, const Prefilter &prefilter);
+    int match(const QString &fileName) const;
+
+private:
+    static QString stripAnchors(const QString &filterPattern);
+    void updatePrefilters();
+    static Prefilter derivePrefilter(const QString &filterPattern);
+    static bool scanAlternatives(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString *prefix);
+    static bool scanSequence(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString *prefix);
+    static bool scanAtom(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString &literal);
+    static bool scanGroup(const QString &pattern, int &position, int &minimumLength, int &maximumLength);
+    static bool scanClass(const QString &pattern, int &position);
+    static bool scanEscape(const QString &pattern, int &position, int &minimumLength, int &maximumLength, QString &literal);
+    static void scanQuantifier(const QString &pattern, int &position, int &minimumCount, int &maximumCount);
+    static int addLength(int length, int addedLength);
+    static int multiplyLength(int length, int count);
+    bool passesPrefilters(const QString &fileName) const;
+    static bool passesPrefilter(const Prefilter &prefilter, const QString &fileName, const QString &extension);
+};
+
+#endif // FILTERSET_H
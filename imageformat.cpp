@@ -0,0 +1,44 @@
+// Local
+#include "imageformat.h"
+
+const int ImageFormat::HEADER_SIZE(16);
+
+ImageFormat::Format ImageFormat::sniff(const QByteArray &header)
+{
+    if (header.startsWith("\xFF\xD8\xFF"))
+    {
+        return Format_Jpeg;
+    }
+
+    // Raw camera formats (CR2, NEF, DNG, ARW...) are TIFF too.
+    if (header.startsWith(QByteArray("II*\0", 4)) || header.startsWith(QByteArray("MM\0*", 4)))
+    {
+        return Format_Tiff;
+    }
+    if (header.startsWith("\x89PNG\r\n\x1A\n"))
+    {
+        return Format_Png;
+    }
+    if (header.startsWith("GIF87a") || header.startsWith("GIF89a"))
+    {
+        return Format_Gif;
+    }
+    if (header.startsWith("BM"))
+    {
+        return Format_Bmp;
+    }
+
+    return Format_Unknown;
+}
+
+bool ImageFormat::canCarryExif(Format format)
+{
+    switch (format)
+    {
+    case Format_Gif:
+    case Format_Bmp:
+        return false;
+    default:
+        return true;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef IMAGEFORMAT_H
+#define IMAGEFORMAT_H
+
+// Qt
+#include <QByteArray>
+
+// Tells image formats apart from the first bytes of the file, so each one goes straight to the
+// extractor that can read it, and formats which cannot carry Exif are not parsed at all.
+class ImageFormat
+{
+public:
+    enum Format
+    {
+        Format_Unknown,
+        Format_Jpeg,
+        Format_Tiff,
+        Format_Png,
+        Format_Gif,
+        Format_Bmp
+    };
+    static const int HEADER_SIZE;
+
+public:
+    static Format sniff(const QByteArray &header);
+    static bool canCarryExif(Format format);
+};
+
+#endif // IMAGEFORMAT_H
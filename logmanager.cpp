@@ -2,6 +2,7 @@
 #include <iostream>
 
 // Qt
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
@@ -10,12 +11,15 @@
 // Local
 #include "logmanager.h"
 #include "applicationutils.h"
+#include "logwriter.h"
 
 const QString LogManager::m_LOG_FILENAME(ApplicationUtils::APPLICATION_NAME + ".txt");
 const QString LogManager::m_LOG_DATE_TIME_FORMAT("yyyy-MM-dd HH.mm.ss.zzz ");
 QString LogManager::m_logPath("");
 QString LogManager::m_logAbsoluteFilePath("");
 QMutex LogManager::m_mutex;
+LogWriter *LogManager::m_logWriter(NULL);
+LogManager::LogLevel LogManager::m_logLevel(LogManager::LogLevel_Debug);
 
 LogManager::LogManager(const QString &logTag, QObject *parent) :
     QObject(parent),
@@ -43,6 +47,25 @@ void LogManager::initialize(const QString &applicationDirPath)
     QTextStream text_stream(&log_file);
     text_stream << log_header << endl << flush;
     log_file.close();
+
+    // Start the background writer, it keeps the log file open until the application quits.
+    m_logWriter = new LogWriter(m_logAbsoluteFilePath);
+    m_logWriter->start(QThread::LowPriority);
+    qAddPostRoutine(LogManager::finalize);
+}
+
+void LogManager::finalize()
+{
+    if (m_logWriter == NULL)
+    {
+        return;
+    }
+
+    // Drain the queue and close the log file; later messages are written synchronously.
+    LogWriter *log_writer = m_logWriter;
+    m_logWriter = NULL;
+    log_writer->stop();
+    delete log_writer;
 }
 
 void LogManager::messageHandler(QtMsgType messageType, const QMessageLogContext &messageLogContext, const QString &message)
@@ -55,6 +78,10 @@ void LogManager::messageHandler(QtMsgType messageType, const QMessageLogContext
     case QtDebugMsg:
         message_type = "   ";
 
+        break;
+    case QtInfoMsg:
+        message_type = "INF";
+
         break;
     case QtWarningMsg:
         message_type = "WRN";
@@ -76,6 +103,24 @@ void LogManager::messageHandler(QtMsgType messageType, const QMessageLogContext
     QString message_string(QDateTime::currentDateTime().toString(m_LOG_DATE_TIME_FORMAT));
     message_string += QString("%1 %2").arg(message_type).arg(message);
 
+    // Hand the message over to the background writer.
+    if (m_logWriter != NULL)
+    {
+        LogWriter::LogEntry log_entry;
+        log_entry.fileLine = message_string.toUtf8();
+        log_entry.consoleLine = message.toLocal8Bit();
+        log_entry.standardError = messageType != QtDebugMsg && messageType != QtInfoMsg;
+        m_logWriter->write(log_entry);
+
+        // The application aborts right after a fatal message, make sure it gets out.
+        if (messageType == QtFatalMsg)
+        {
+            LogManager::finalize();
+        }
+
+        return;
+    }
+
     // Log to file.
     QFile log_file(m_logAbsoluteFilePath);
     log_file.open(QIODevice::WriteOnly | QIODevice::Append);
@@ -85,12 +130,58 @@ void LogManager::messageHandler(QtMsgType messageType, const QMessageLogContext
 
     // Log to the output file.
     FILE *output_file = NULL;
-    output_file = messageType == QtDebugMsg ? stdout : stderr;
+    output_file = messageType == QtDebugMsg || messageType == QtInfoMsg ? stdout : stderr;
     fprintf(output_file, "%s\n", message.toStdString().c_str());
 }
 
+LogManager::LogLevel LogManager::logLevel()
+{
+    return m_logLevel;
+}
+
+void LogManager::setLogLevel(LogLevel logLevel)
+{
+    m_logLevel = logLevel;
+}
+
+bool LogManager::parseLogLevel(const QString &logLevelName, LogLevel &logLevel)
+{
+    QString log_level_name = logLevelName.toLower();
+    if (log_level_name == "debug")
+    {
+        logLevel = LogLevel_Debug;
+    }
+    else if (log_level_name == "info")
+    {
+        logLevel = LogLevel_Info;
+    }
+    else if (log_level_name == "warning")
+    {
+        logLevel = LogLevel_Warning;
+    }
+    else if (log_level_name == "error")
+    {
+        logLevel = LogLevel_Error;
+    }
+    else if (log_level_name == "none")
+    {
+        logLevel = LogLevel_None;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
 void LogManager::debug(const QString &debugMessage)
 {
+    if (!LogManager::isLogLevelEnabled(LogLevel_Debug))
+    {
+        return;
+    }
+
     QMutexLocker mutex_locker(&m_mutex);
 
     emit this->debugMessage(debugMessage);
@@ -98,8 +189,27 @@ void LogManager::debug(const QString &debugMessage)
     qDebug() << qPrintable(m_logTag.rightJustified(5, ' ')) << ">" << qPrintable(debugMessage);
 }
 
+void LogManager::info(const QString &infoMessage)
+{
+    if (!LogManager::isLogLevelEnabled(LogLevel_Info))
+    {
+        return;
+    }
+
+    QMutexLocker mutex_locker(&m_mutex);
+
+    emit this->infoMessage(infoMessage);
+
+    qInfo() << qPrintable(m_logTag.rightJustified(5, ' ')) << ">" << qPrintable(infoMessage);
+}
+
 void LogManager::warning(const QString &warningMessage)
 {
+    if (!LogManager::isLogLevelEnabled(LogLevel_Warning))
+    {
+        return;
+    }
+
     QMutexLocker mutex_locker(&m_mutex);
 
     emit this->warningMessage(warningMessage);
@@ -109,6 +219,11 @@ void LogManager::warning(const QString &warningMessage)
 
 void LogManager::error(const QString &errorMessage)
 {
+    if (!LogManager::isLogLevelEnabled(LogLevel_Error))
+    {
+        return;
+    }
+
     QMutexLocker mutex_locker(&m_mutex);
 
     emit this->errorMessage(errorMessage);
@@ -6,16 +6,42 @@
 #include <QMutex>
 #include <QDebug>
 
+// Lowest level compiled in, messages below it cost nothing at run time (0: debug, 1: info, 2: warning, 3: error).
+#ifndef LOG_MINIMUM_LEVEL
+#define LOG_MINIMUM_LEVEL 0
+#endif
+
+// Level-gated logging from LogManager subclasses: the message expression is only evaluated
+// when its level is enabled, so disabled messages are neither formatted nor locked.
+#define LOG_DEBUG(message) do { if (LogManager::isLogLevelEnabled(LogManager::LogLevel_Debug)) { this->debug(message); } } while (0)
+#define LOG_INFO(message) do { if (LogManager::isLogLevelEnabled(LogManager::LogLevel_Info)) { this->info(message); } } while (0)
+#define LOG_WARNING(message) do { if (LogManager::isLogLevelEnabled(LogManager::LogLevel_Warning)) { this->warning(message); } } while (0)
+#define LOG_ERROR(message) do { if (LogManager::isLogLevelEnabled(LogManager::LogLevel_Error)) { this->error(message); } } while (0)
+
+class LogWriter;
+
 class LogManager : public QObject
 {
     Q_OBJECT
 
+public:
+    enum LogLevel
+    {
+        LogLevel_Debug = 0,
+        LogLevel_Info = 1,
+        LogLevel_Warning = 2,
+        LogLevel_Error = 3,
+        LogLevel_None = 4
+    };
+
 private:
     static const QString m_LOG_FILENAME;
     static const QString m_LOG_DATE_TIME_FORMAT;
     static QString m_logPath;
     static QString m_logAbsoluteFilePath;
     static QMutex m_mutex;
+    static LogWriter *m_logWriter;
+    static LogLevel m_logLevel;
     QString m_logTag;
 
 public:
@@ -24,15 +50,25 @@ public:
 
 public:
     static void initialize(const QString &applicationDirPath);
+    static void finalize();
     static void messageHandler(QtMsgType messageType, const QMessageLogContext &messageLogContext, const QString &message);
+    static LogLevel logLevel();
+    static void setLogLevel(LogLevel logLevel);
+    static bool parseLogLevel(const QString &logLevelName, LogLevel &logLevel);
+    static inline bool isLogLevelEnabled(LogLevel logLevel)
+    {
+        return logLevel >= LOG_MINIMUM_LEVEL && logLevel >= m_logLevel;
+    }
 
 protected:
     void debug(const QString &debugMessage);
+    void info(const QString &infoMessage);
     void warning(const QString &warningMessage);
     void error(const QString &errorMessage);
 
 signals:
     void debugMessage(const QString &debugMessage);
+    void infoMessage(const QString &infoMessage);
     void warningMessage(const QString &warningMessage);
     void errorMessage(const QString &errorMessage);
 };
@@ -0,0 +1,177 @@
+// Std
+#include <climits>
+#include <cstdio>
+
+// Qt
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// Local
+#include "logwriter.h"
+
+const size_t LogWriter::m_QUEUE_CAPACITY(8192);
+const int LogWriter::m_FLUSH_SIZE(64 * 1024);
+const int LogWriter::m_FLUSH_INTERVAL_MS(200);
+
+LogWriter::LogWriter(const QString &logAbsoluteFilePath, QObject *parent) :
+    QThread(parent),
+    m_queue(m_QUEUE_CAPACITY),
+    m_queuedCount(0),
+    m_blockedWriterCount(0),
+    m_wakeMutex(),
+    m_entryQueued(),
+    m_entryTaken(),
+    m_logFile(logAbsoluteFilePath),
+    m_stopRequested(false),
+    m_fileBuffer(),
+    m_standardOutputBuffer(),
+    m_standardErrorBuffer()
+{
+    m_logFile.open(QIODevice::WriteOnly | QIODevice::Append);
+    m_fileBuffer.reserve(m_FLUSH_SIZE * 2);
+}
+
+LogWriter::~LogWriter()
+{
+    this->stop();
+
+    m_logFile.close();
+}
+
+void LogWriter::write(const LogEntry &logEntry)
+{
+    // The queue is bounded: when the writer falls behind, wait for it rather than dropping messages.
+    // Retry under the lock the writer signals under once it took entries, so no wake-up is missed.
+    if (!m_queue.tryEnqueue(logEntry))
+    {
+        QMutexLocker mutex_locker(&m_wakeMutex);
+        m_blockedWriterCount.fetch_add(1);
+        while (!m_queue.tryEnqueue(logEntry))
+        {
+            m_entryTaken.wait(&m_wakeMutex);
+        }
+        m_blockedWriterCount.fetch_sub(1);
+    }
+
+    // Only the message that makes the queue non-empty wakes the writer.
+    if (m_queuedCount.fetch_add(1) == 0)
+    {
+        QMutexLocker mutex_locker(&m_wakeMutex);
+        m_entryQueued.wakeOne();
+    }
+}
+
+void LogWriter::stop()
+{
+    if (!this->isRunning())
+    {
+        return;
+    }
+
+    m_stopRequested.store(true);
+    {
+        QMutexLocker mutex_locker(&m_wakeMutex);
+        m_entryQueued.wakeOne();
+    }
+    this->wait();
+}
+
+void LogWriter::run()
+{
+    QElapsedTimer flush_timer;
+    flush_timer.start();
+
+    while (!m_stopRequested.load())
+    {
+        bool dequeued = this->drain();
+
+        // Flush at least every interval, so a quiet run still shows up in the log.
+        if (flush_timer.elapsed() >= m_FLUSH_INTERVAL_MS)
+        {
+            this->flush();
+            flush_timer.restart();
+        }
+
+        if (dequeued)
+        {
+            continue;
+        }
+
+        // Sleep until a message is queued, or until the pending output is due to be flushed.
+        QMutexLocker mutex_locker(&m_wakeMutex);
+        if (m_queuedCount.load() <= 0 && !m_stopRequested.load())
+        {
+            unsigned long wait_ms = ULONG_MAX;
+            if (!m_fileBuffer.isEmpty() || !m_standardOutputBuffer.isEmpty() || !m_standardErrorBuffer.isEmpty())
+            {
+                wait_ms = static_cast<unsigned long>(qMax(m_FLUSH_INTERVAL_MS - flush_timer.elapsed(), Q_INT64_C(1)));
+            }
+            m_entryQueued.wait(&m_wakeMutex, wait_ms);
+        }
+    }
+
+    // Write whatever is still queued before leaving.
+    this->drain();
+    this->flush();
+}
+
+bool LogWriter::drain()
+{
+    bool dequeued = false;
+    LogEntry log_entry;
+    while (m_queue.tryDequeue(log_entry))
+    {
+        dequeued = true;
+        m_queuedCount.fetch_sub(1);
+
+        this->append(log_entry);
+
+        if (m_fileBuffer.size() >= m_FLUSH_SIZE)
+        {
+            this->flush();
+        }
+    }
+
+    // Room was made: let the writers blocked on a full queue retry.
+    if (dequeued && m_blockedWriterCount.load() > 0)
+    {
+        QMutexLocker mutex_locker(&m_wakeMutex);
+        m_entryTaken.wakeAll();
+    }
+
+    return dequeued;
+}
+
+void LogWriter::append(const LogEntry &logEntry)
+{
+    m_fileBuffer += logEntry.fileLine;
+    m_fileBuffer += '\n';
+
+    QByteArray &console_buffer = logEntry.standardError ? m_standardErrorBuffer : m_standardOutputBuffer;
+    console_buffer += logEntry.consoleLine;
+    console_buffer += '\n';
+}
+
+void LogWriter::flush()
+{
+    if (!m_fileBuffer.isEmpty())
+    {
+        m_logFile.write(m_fileBuffer);
+        m_logFile.flush();
+        m_fileBuffer.resize(0);
+    }
+
+    if (!m_standardOutputBuffer.isEmpty())
+    {
+        fwrite(m_standardOutputBuffer.constData(), 1, m_standardOutputBuffer.size(), stdout);
+        fflush(stdout);
+        m_standardOutputBuffer.resize(0);
+    }
+
+    if (!m_standardErrorBuffer.isEmpty())
+    {
+        fwrite(m_standardErrorBuffer.constData(), 1, m_standardErrorBuffer.size(), stderr);
+        fflush(stderr);
+        m_standardErrorBuffer.resize(0);
+    }
+}
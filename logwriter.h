@@ -0,0 +1,65 @@
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+// Std
+#include <atomic>
+
+// Qt
+#include <QThread>
+#include <QFile>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+
+// Local
+#include "boundedqueue.h"
+
+// Background log sink: messages are queued without locking and written in batches
+// by a dedicated thread through one persistent file handle. The thread sleeps while the
+// queue is empty, and is only woken when a message lands in it.
+class LogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct LogEntry
+    {
+        QByteArray fileLine;
+        QByteArray consoleLine;
+        bool standardError;
+    };
+
+private:
+    static const size_t m_QUEUE_CAPACITY;
+    static const int m_FLUSH_SIZE;
+    static const int m_FLUSH_INTERVAL_MS;
+    BoundedQueue<LogEntry> m_queue;
+    std::atomic<int> m_queuedCount;
+    std::atomic<int> m_blockedWriterCount;
+    QMutex m_wakeMutex;
+    QWaitCondition m_entryQueued;
+    QWaitCondition m_entryTaken;
+    QFile m_logFile;
+    std::atomic<bool> m_stopRequested;
+    QByteArray m_fileBuffer;
+    QByteArray m_standardOutputBuffer;
+    QByteArray m_standardErrorBuffer;
+
+public:
+    explicit LogWriter(const QString &logAbsoluteFilePath, QObject *parent = NULL);
+    ~LogWriter();
+
+public:
+    void write(const LogEntry &logEntry);
+    void stop();
+
+protected:
+    void run();
+
+private:
+    bool drain();
+    void append(const LogEntry &logEntry);
+    void flush();
+};
+
+#endif // LOGWRITER_H
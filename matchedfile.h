@@ -0,0 +1,33 @@
+#ifndef MATCHEDFILE_H
+#define MATCHEDFILE_H
+
+// Qt
+#include <QFileInfo>
+#include <QList>
+
+// Local
+#include "filterset.h"
+
+// A file whose name matched one of the filters, with the id of the filter it matched.
+// The id travels with the file, so its name is matched against the filters only once.
+struct MatchedFile
+{
+    QFileInfo file;
+    int fileFilterId;
+
+    MatchedFile() :
+        file(),
+        fileFilterId(FilterSet::NO_MATCH)
+    {
+    }
+
+    MatchedFile(const QFileInfo &file, int fileFilterId) :
+        file(file),
+        fileFilterId(fileFilterId)
+    {
+    }
+};
+
+typedef QList<MatchedFile> MatchedFileList;
+
+#endif // MATCHEDFILE_H
@@ -0,0 +1,273 @@
+// Std
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Qt
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QSaveFile>
+
+#ifndef Q_OS_WIN
+// Posix
+#include <sys/stat.h>
+#endif
+
+// Local
+#include "metadatacache.h"
+
+const char MetadataCache::m_MAGIC[8] = { 'M', 'F', 'R', 'C', 'A', 'C', 'H', 'E' };
+const quint32 MetadataCache::m_VERSION(2);
+
+MetadataCache::MetadataCache() :
+    m_cacheFile(),
+    m_records(NULL),
+    m_recordCount(0),
+    m_mutex(),
+    m_newRecords(),
+    m_open(false)
+{
+}
+
+MetadataCache::~MetadataCache()
+{
+    this->close();
+}
+
+bool MetadataCache::open(const QString &cacheFilePath)
+{
+    this->close();
+
+    m_cacheFile.setFileName(cacheFilePath);
+    m_open = true;
+
+    // A missing or unreadable cache file just means an empty cache, it is rewritten on save.
+    if (!m_cacheFile.exists() || !m_cacheFile.open(QIODevice::ReadOnly))
+    {
+        return true;
+    }
+
+    const qint64 header_size = sizeof(m_MAGIC) + 2 * sizeof(quint32);
+    QByteArray header = m_cacheFile.read(header_size);
+    if (header.size() != header_size || !header.startsWith(QByteArray(m_MAGIC, sizeof(m_MAGIC))))
+    {
+        m_cacheFile.close();
+
+        return true;
+    }
+    quint32 version;
+    quint32 record_count;
+    memcpy(&version, header.constData() + sizeof(m_MAGIC), sizeof(version));
+    memcpy(&record_count, header.constData() + sizeof(m_MAGIC) + sizeof(version), sizeof(record_count));
+    qint64 records_size = static_cast<qint64>(record_count) * sizeof(Record);
+    if (version != m_VERSION || m_cacheFile.size() != header_size + records_size)
+    {
+        m_cacheFile.close();
+
+        return true;
+    }
+
+    if (record_count > 0)
+    {
+        uchar *records = m_cacheFile.map(header_size, records_size);
+        if (records == NULL)
+        {
+            m_cacheFile.close();
+
+            return true;
+        }
+        m_records = reinterpret_cast<const Record *>(records);
+        m_recordCount = record_count;
+    }
+
+    return true;
+}
+
+bool MetadataCache::isOpen() const
+{
+    return m_open;
+}
+
+bool MetadataCache::save()
+{
+    if (!m_open || m_newRecords.isEmpty())
+    {
+        return true;
+    }
+
+    // Merge the mapped records with the new ones, new records win on equal keys.
+    std::vector<Record> records;
+    records.reserve(m_newRecords.count() + m_recordCount);
+    foreach (const Record &record, m_newRecords)
+    {
+        records.push_back(record);
+    }
+    records.insert(records.end(), m_records, m_records + m_recordCount);
+    std::stable_sort(records.begin(), records.end(), MetadataCache::recordLessThan);
+    std::vector<Record>::iterator records_end = std::unique(records.begin(), records.end(), MetadataCache::recordEqual);
+    records.erase(records_end, records.end());
+
+    // The mapping must go before the file can be replaced.
+    QString cache_file_path = m_cacheFile.fileName();
+    if (m_records != NULL)
+    {
+        m_cacheFile.unmap(reinterpret_cast<uchar *>(const_cast<Record *>(m_records)));
+        m_records = NULL;
+        m_recordCount = 0;
+    }
+    m_cacheFile.close();
+
+    QSaveFile save_file(cache_file_path);
+    if (!save_file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    quint32 record_count = static_cast<quint32>(records.size());
+    save_file.write(m_MAGIC, sizeof(m_MAGIC));
+    save_file.write(reinterpret_cast<const char *>(&m_VERSION), sizeof(m_VERSION));
+    save_file.write(reinterpret_cast<const char *>(&record_count), sizeof(record_count));
+    if (record_count > 0)
+    {
+        save_file.write(reinterpret_cast<const char *>(records.data()), record_count * sizeof(Record));
+    }
+    if (!save_file.commit())
+    {
+        return false;
+    }
+
+    m_newRecords.clear();
+
+    return true;
+}
+
+void MetadataCache::close()
+{
+    if (!m_open)
+    {
+        return;
+    }
+
+    this->save();
+
+    if (m_records != NULL)
+    {
+        m_cacheFile.unmap(reinterpret_cast<uchar *>(const_cast<Record *>(m_records)));
+        m_records = NULL;
+        m_recordCount = 0;
+    }
+    m_cacheFile.close();
+    m_newRecords.clear();
+    m_open = false;
+}
+
+int MetadataCache::recordCount() const
+{
+    return m_recordCount;
+}
+
+bool MetadataCache::makeKey(const QFileInfo &file, Key &key)
+{
+#ifdef Q_OS_WIN
+    // There is no inode without opening the file: use a digest of the path instead.
+    QByteArray path_digest = QCryptographicHash::hash(file.absoluteFilePath().toUtf8(), QCryptographicHash::Md5);
+    key.device = 0;
+    memcpy(&key.inode, path_digest.constData(), sizeof(key.inode));
+    key.size = file.size();
+    key.modificationTime = file.lastModified().toMSecsSinceEpoch() * 1000000;
+#else
+    struct stat file_stat;
+    if (stat(QFile::encodeName(file.absoluteFilePath()).constData(), &file_stat) != 0)
+    {
+        return false;
+    }
+    key.device = file_stat.st_dev;
+    key.inode = file_stat.st_ino;
+    key.size = file_stat.st_size;
+#if defined(Q_OS_LINUX)
+    key.modificationTime = static_cast<qint64>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+#elif defined(Q_OS_MAC)
+    key.modificationTime = static_cast<qint64>(file_stat.st_mtimespec.tv_sec) * 1000000000 + file_stat.st_mtimespec.tv_nsec;
+#else
+    key.modificationTime = static_cast<qint64>(file_stat.st_mtime) * 1000000000;
+#endif
+#endif
+
+    return true;
+}
+
+bool MetadataCache::lookup(const Key &key, QString &timestamp, TimestampSource &source) const
+{
+    // The mapped records are never modified during a run, no lock needed.
+    const Record *records_end = m_records + m_recordCount;
+    const Record *record = std::lower_bound(m_records, records_end, key, MetadataCache::lessThan);
+    if (record == records_end || !MetadataCache::isEqual(*record, key))
+    {
+        return false;
+    }
+
+    timestamp = QString::fromLatin1(record->timestamp, qstrnlen(record->timestamp, sizeof(record->timestamp)));
+    source = static_cast<TimestampSource>(record->source);
+
+    return true;
+}
+
+void MetadataCache::insert(const Key &key, const QString &timestamp, TimestampSource source)
+{
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.device = key.device;
+    record.inode = key.inode;
+    record.size = key.size;
+    record.modificationTime = key.modificationTime;
+    record.source = source;
+    QByteArray timestamp_latin1 = timestamp.toLatin1();
+    memcpy(record.timestamp, timestamp_latin1.constData(), qMin<int>(timestamp_latin1.size(), sizeof(record.timestamp) - 1));
+
+    QMutexLocker mutex_locker(&m_mutex);
+
+    m_newRecords.insert(MetadataCache::keyBytes(key), record);
+}
+
+bool MetadataCache::lessThan(const Record &record, const Key &key)
+{
+    if (record.device != key.device)
+    {
+        return record.device < key.device;
+    }
+    if (record.inode != key.inode)
+    {
+        return record.inode < key.inode;
+    }
+    if (record.size != key.size)
+    {
+        return record.size < key.size;
+    }
+
+    return record.modificationTime < key.modificationTime;
+}
+
+bool MetadataCache::isEqual(const Record &record, const Key &key)
+{
+    return record.device == key.device && record.inode == key.inode && record.size == key.size && record.modificationTime == key.modificationTime;
+}
+
+bool MetadataCache::recordLessThan(const Record &left, const Record &right)
+{
+    Key right_key;
+    right_key.device = right.device;
+    right_key.inode = right.inode;
+    right_key.size = right.size;
+    right_key.modificationTime = right.modificationTime;
+
+    return MetadataCache::lessThan(left, right_key);
+}
+
+bool MetadataCache::recordEqual(const Record &left, const Record &right)
+{
+    return !MetadataCache::recordLessThan(left, right) && !MetadataCache::recordLessThan(right, left);
+}
+
+QByteArray MetadataCache::keyBytes(const Key &key)
+{
+    return QByteArray(reinterpret_cast<const char *>(&key), sizeof(key));
+}
@@ -0,0 +1,73 @@
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+// Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// Persistent cache of extracted image timestamps, keyed by (device, inode, size, mtime).
+// The cache file is a sorted array of fixed-size records which is memory-mapped and
+// binary-searched, so a hit costs one stat and no file open.
+// Entries added during a run are merged into the file when it is saved.
+class MetadataCache
+{
+public:
+    enum TimestampSource
+    {
+        TimestampSource_Exif = 0,
+        TimestampSource_FileTime = 1,
+        TimestampSource_FileName = 2
+    };
+    struct Key
+    {
+        quint64 device;
+        quint64 inode;
+        qint64 size;
+        qint64 modificationTime;
+    };
+
+private:
+    struct Record
+    {
+        quint64 device;
+        quint64 inode;
+        qint64 size;
+        qint64 modificationTime;
+        quint32 source;
+        char timestamp[24];
+    };
+    static const char m_MAGIC[8];
+    static const quint32 m_VERSION;
+    QFile m_cacheFile;
+    const Record *m_records;
+    quint32 m_recordCount;
+    QMutex m_mutex;
+    QHash<QByteArray, Record> m_newRecords;
+    bool m_open;
+
+public:
+    MetadataCache();
+    ~MetadataCache();
+
+public:
+    bool open(const QString &cacheFilePath);
+    bool isOpen() const;
+    bool save();
+    void close();
+    int recordCount() const;
+    static bool makeKey(const QFileInfo &file, Key &key);
+    bool lookup(const Key &key, QString &timestamp, TimestampSource &source) const;
+    void insert(const Key &key, const QString &timestamp, TimestampSource source);
+
+private:
+    static bool lessThan(const Record &record, const Key &key);
+    static bool isEqual(const Record &record, const Key &key);
+    static bool recordLessThan(const Record &left, const Record &right);
+    static bool recordEqual(const Record &left, const Record &right);
+    static QByteArray keyBytes(const Key &key);
+};
+
+#endif // METADATACACHE_H
@@ -0,0 +1,126 @@
+// Local
+#include "directoryreader.h"
+#include "namereservation.h"
+
+NameReservation::NameReservation() :
+    m_mutex(),
+    m_reservedNames(),
+    m_listedNames(),
+    m_vacatedNames(),
+    m_directoryListingCount(0),
+    m_lookupCount(0)
+{
+}
+
+bool NameReservation::reserve(const QDir &directory, const QString &fileName, bool deferred)
+{
+    QMutexLocker mutex_locker(&m_mutex);
+
+    QString directory_path = directory.absolutePath();
+    QString name_key = NameReservation::nameKey(fileName);
+    QSet<QString> &reserved_names = m_reservedNames[directory_path];
+    m_lookupCount++;
+    if (reserved_names.contains(name_key))
+    {
+        return false;
+    }
+
+    // A deferred rename can't rely on the rename itself refusing a name already on disk.
+    if (deferred && this->listedNames(directory_path).contains(name_key))
+    {
+        return false;
+    }
+
+    reserved_names.insert(name_key);
+
+    return true;
+}
+
+void NameReservation::release(const QDir &directory, const QString &fileName)
+{
+    QMutexLocker mutex_locker(&m_mutex);
+
+    m_reservedNames[directory.absolutePath()].remove(NameReservation::nameKey(fileName));
+}
+
+void NameReservation::vacate(const QDir &directory, const QString &fileName, bool deferred)
+{
+    QMutexLocker mutex_locker(&m_mutex);
+
+    QString directory_path = directory.absolutePath();
+    QString name_key = NameReservation::nameKey(fileName);
+    m_reservedNames[directory_path].remove(name_key);
+
+    // A file only planned to be moved is still on disk: a directory not listed yet drops its name when it is.
+    QHash<QString, QSet<QString> >::iterator listed_names = m_listedNames.find(directory_path);
+    if (listed_names != m_listedNames.end())
+    {
+        listed_names.value().remove(name_key);
+    }
+    else if (deferred)
+    {
+        m_vacatedNames[directory_path].insert(name_key);
+    }
+}
+
+void NameReservation::clear()
+{
+    QMutexLocker mutex_locker(&m_mutex);
+
+    m_reservedNames.clear();
+    m_listedNames.clear();
+    m_vacatedNames.clear();
+}
+
+int NameReservation::directoryListingCount()
+{
+    QMutexLocker mutex_locker(&m_mutex);
+
+    return m_directoryListingCount;
+}
+
+int NameReservation::lookupCount()
+{
+    QMutexLocker mutex_locker(&m_mutex);
+
+    return m_lookupCount;
+}
+
+QSet<QString> &NameReservation::listedNames(const QString &directoryPath)
+{
+    QHash<QString, QSet<QString> >::iterator listed_names = m_listedNames.find(directoryPath);
+    if (listed_names != m_listedNames.end())
+    {
+        return listed_names.value();
+    }
+
+    // First use of this directory: take a snapshot of every name in it. A directory that doesn't exist
+    // yet (an archive bucket) has no names.
+    QSet<QString> names;
+    DirectoryReader directory_reader;
+    if (directory_reader.open(directoryPath))
+    {
+        QString file_name;
+        DirectoryReader::EntryType entry_type;
+        while (directory_reader.next(file_name, entry_type))
+        {
+            names.insert(NameReservation::nameKey(file_name));
+        }
+    }
+    m_directoryListingCount++;
+
+    // Names planned to be moved away by this run before the listing are free.
+    names.subtract(m_vacatedNames.take(directoryPath));
+
+    return m_listedNames.insert(directoryPath, names).value();
+}
+
+QString NameReservation::nameKey(const QString &fileName)
+{
+#ifdef Q_OS_WIN
+    // Windows file names are case-insensitive.
+    return fileName.toLower();
+#else
+    return fileName;
+#endif
+}
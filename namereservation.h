@@ -0,0 +1,43 @@
+#ifndef NAMERESERVATION_H
+#define NAMERESERVATION_H
+
+// Qt
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+// Keeps track of the file names taken in each directory during the run, so that two renames never get
+// the same target name even when they are committed concurrently.
+// Direct renames only index the names reserved by this run, so memory doesn't grow with the directories:
+// a name already on disk is refused by the no-replace rename itself. Deferred renames (plan, journal) are
+// refused too late for that, so for them each target directory is listed once, on first use, and the
+// names on disk are answered from that snapshot, kept up to date with the renames of the run.
+class NameReservation
+{
+private:
+    QMutex m_mutex;
+    QHash<QString, QSet<QString> > m_reservedNames;
+    QHash<QString, QSet<QString> > m_listedNames;
+    QHash<QString, QSet<QString> > m_vacatedNames;
+    int m_directoryListingCount;
+    int m_lookupCount;
+
+public:
+    NameReservation();
+
+public:
+    bool reserve(const QDir &directory, const QString &fileName, bool deferred = false);
+    void release(const QDir &directory, const QString &fileName);
+    void vacate(const QDir &directory, const QString &fileName, bool deferred = false);
+    void clear();
+    int directoryListingCount();
+    int lookupCount();
+
+private:
+    QSet<QString> &listedNames(const QString &directoryPath);
+    static QString nameKey(const QString &fileName);
+};
+
+#endif // NAMERESERVATION_H
@@ -0,0 +1,390 @@
+// Local
+#include "nametemplate.h"
+
+const QString NameTemplate::DEFAULT_TEMPLATE("{date} {time}.{ext}");
+const int NameTemplate::MAXIMUM_NAME_LENGTH;
+
+NameTemplate::NameTemplate() :
+    m_segments(),
+    m_hasSequence(false),
+    m_hasMillisecond(false)
+{
+}
+
+bool NameTemplate::compile(const QString &nameTemplate, QString *errorString)
+{
+    QList<Segment> segments;
+    bool has_sequence = false;
+    bool has_millisecond = false;
+    int position = 0;
+    while (position < nameTemplate.length())
+    {
+        int field_start = nameTemplate.indexOf('{', position);
+        int literal_end = field_start != -1 ? field_start : nameTemplate.length();
+        if (literal_end > position)
+        {
+            Segment segment;
+            segment.field = Field_Literal;
+            segment.literal = nameTemplate.mid(position, literal_end - position);
+            segments.append(segment);
+        }
+        if (field_start == -1)
+        {
+            break;
+        }
+
+        int field_end = nameTemplate.indexOf('}', field_start);
+        Segment segment;
+        if (field_end == -1 || !NameTemplate::parseField(nameTemplate.mid(field_start + 1, field_end - field_start - 1), segment.field))
+        {
+            if (errorString != NULL)
+            {
+                *errorString = "Invalid field in the name template: " + nameTemplate.mid(field_start);
+            }
+
+            return false;
+        }
+        segments.append(segment);
+        has_sequence = has_sequence || segment.field == Field_Sequence;
+        has_millisecond = has_millisecond || segment.field == Field_Millisecond;
+
+        position = field_end + 1;
+    }
+
+    // The names must stay in the directory of the file.
+    if (segments.isEmpty() || nameTemplate.contains('/') || nameTemplate.contains('\\'))
+    {
+        if (errorString != NULL)
+        {
+            *errorString = "Invalid name template: " + nameTemplate;
+        }
+
+        return false;
+    }
+
+    m_segments = segments;
+    m_hasSequence = has_sequence;
+    m_hasMillisecond = has_millisecond;
+
+    return true;
+}
+
+bool NameTemplate::hasSequence() const
+{
+    return m_hasSequence;
+}
+
+bool NameTemplate::hasMillisecond() const
+{
+    return m_hasMillisecond;
+}
+
+int NameTemplate::format(const Timestamp &timestamp, int sequence, const QString &extension, QChar *buffer) const
+{
+    // Returns the length of the name, -1 when it doesn't fit in MAXIMUM_NAME_LENGTH.
+    int length = 0;
+    for (int i = 0; i < m_segments.count() && length != -1; i++)
+    {
+        const Segment &segment = m_segments.at(i);
+        switch (segment.field)
+        {
+        case Field_Literal:
+            length = NameTemplate::writeString(buffer, length, segment.literal);
+            break;
+        case Field_Year:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.year, 4);
+            break;
+        case Field_Month:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.month, 2);
+            break;
+        case Field_Day:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.day, 2);
+            break;
+        case Field_Hour:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.hour, 2);
+            break;
+        case Field_Minute:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.minute, 2);
+            break;
+        case Field_Second:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.second, 2);
+            break;
+        case Field_Millisecond:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.millisecond, 3);
+            break;
+        case Field_Date:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.year, 4);
+            length = NameTemplate::writeString(buffer, length, QStringLiteral("-"));
+            length = NameTemplate::writeNumber(buffer, length, timestamp.month, 2);
+            length = NameTemplate::writeString(buffer, length, QStringLiteral("-"));
+            length = NameTemplate::writeNumber(buffer, length, timestamp.day, 2);
+            break;
+        case Field_Time:
+            length = NameTemplate::writeNumber(buffer, length, timestamp.hour, 2);
+            length = NameTemplate::writeString(buffer, length, QStringLiteral("."));
+            length = NameTemplate::writeNumber(buffer, length, timestamp.minute, 2);
+            length = NameTemplate::writeString(buffer, length, QStringLiteral("."));
+            length = NameTemplate::writeNumber(buffer, length, timestamp.second, 2);
+            break;
+        case Field_Sequence:
+            length = NameTemplate::writeNumber(buffer, length, sequence, 2);
+            break;
+        case Field_Extension:
+            length = NameTemplate::writeString(buffer, length, extension);
+            break;
+        }
+    }
+
+    return length;
+}
+
+bool NameTemplate::parseTimestamp(const QString &timestamp, Timestamp &parsedTimestamp)
+{
+    // Either the renamer format, "yyyy-MM-dd HH.mm.ss" with ".zzz" when the milliseconds are known,
+    // or the Exif one, "yyyy:MM:dd HH:mm:ss". Anything else after the seconds is ignored.
+    if (timestamp.length() < 19 || timestamp.at(10) != ' ')
+    {
+        return false;
+    }
+    QChar date_separator = timestamp.at(4);
+    QChar time_separator = timestamp.at(13);
+    if ((date_separator != '-' && date_separator != ':') || timestamp.at(7) != date_separator ||
+        (time_separator != '.' && time_separator != ':') || timestamp.at(16) != time_separator)
+    {
+        return false;
+    }
+
+    parsedTimestamp.year = NameTemplate::parseNumber(timestamp, 0, 4);
+    parsedTimestamp.month = NameTemplate::parseNumber(timestamp, 5, 2);
+    parsedTimestamp.day = NameTemplate::parseNumber(timestamp, 8, 2);
+    parsedTimestamp.hour = NameTemplate::parseNumber(timestamp, 11, 2);
+    parsedTimestamp.minute = NameTemplate::parseNumber(timestamp, 14, 2);
+    parsedTimestamp.second = NameTemplate::parseNumber(timestamp, 17, 2);
+    parsedTimestamp.millisecond = -1;
+    if (timestamp.length() >= 23 && timestamp.at(19) == '.')
+    {
+        parsedTimestamp.millisecond = NameTemplate::parseNumber(timestamp, 20, 3);
+    }
+
+    // Cameras without a set clock write zeroes, which no calendar arithmetic can follow.
+    return parsedTimestamp.year >= 0 &&
+           parsedTimestamp.month >= 1 && parsedTimestamp.month <= 12 &&
+           parsedTimestamp.day >= 1 && parsedTimestamp.day <= NameTemplate::daysInMonth(parsedTimestamp.year, parsedTimestamp.month) &&
+           parsedTimestamp.hour >= 0 && parsedTimestamp.hour < 24 &&
+           parsedTimestamp.minute >= 0 && parsedTimestamp.minute < 60 &&
+           parsedTimestamp.second >= 0 && parsedTimestamp.second < 60;
+}
+
+QString NameTemplate::formatTimestamp(const Timestamp &timestamp)
+{
+    QChar buffer[MAXIMUM_NAME_LENGTH];
+    int length = 0;
+    length = NameTemplate::writeNumber(buffer, length, timestamp.year, 4);
+    length = NameTemplate::writeString(buffer, length, QStringLiteral("-"));
+    length = NameTemplate::writeNumber(buffer, length, timestamp.month, 2);
+    length = NameTemplate::writeString(buffer, length, QStringLiteral("-"));
+    length = NameTemplate::writeNumber(buffer, length, timestamp.day, 2);
+    length = NameTemplate::writeString(buffer, length, QStringLiteral(" "));
+    length = NameTemplate::writeNumber(buffer, length, timestamp.hour, 2);
+    length = NameTemplate::writeString(buffer, length, QStringLiteral("."));
+    length = NameTemplate::writeNumber(buffer, length, timestamp.minute, 2);
+    length = NameTemplate::writeString(buffer, length, QStringLiteral("."));
+    length = NameTemplate::writeNumber(buffer, length, timestamp.second, 2);
+    if (timestamp.millisecond >= 0)
+    {
+        length = NameTemplate::writeString(buffer, length, QStringLiteral("."));
+        length = NameTemplate::writeNumber(buffer, length, timestamp.millisecond, 3);
+    }
+
+    return QString(buffer, length);
+}
+
+void NameTemplate::addSeconds(Timestamp &timestamp, int seconds)
+{
+    // Only ever moves forward, by less than a day at a time.
+    timestamp.second += seconds;
+    timestamp.minute += timestamp.second / 60;
+    timestamp.second %= 60;
+    timestamp.hour += timestamp.minute / 60;
+    timestamp.minute %= 60;
+    timestamp.day += timestamp.hour / 24;
+    timestamp.hour %= 24;
+    if (timestamp.day > NameTemplate::daysInMonth(timestamp.year, timestamp.month))
+    {
+        timestamp.day = 1;
+        timestamp.month++;
+        if (timestamp.month > 12)
+        {
+            timestamp.month = 1;
+            timestamp.year++;
+        }
+    }
+}
+
+int NameTemplate::parseSubSecond(const QString &subSecond)
+{
+    // Exif sub-seconds are the digits of the fraction, "5" being 500 ms and "1234" 123 ms.
+    QString digits = subSecond.trimmed();
+    if (digits.isEmpty())
+    {
+        return -1;
+    }
+
+    int millisecond = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        int digit = 0;
+        if (i < digits.length())
+        {
+            digit = digits.at(i).digitValue();
+            if (digit < 0 || digit > 9)
+            {
+                return -1;
+            }
+        }
+        millisecond = millisecond * 10 + digit;
+    }
+
+    return millisecond;
+}
+
+QString NameTemplate::millisecondTemplate(const QString &nameTemplate)
+{
+    // "{date} {time}.{ext}" becomes "{date} {time}-{msec}.{ext}".
+    QString millisecond_template(nameTemplate);
+    int extension_index = millisecond_template.lastIndexOf(".{ext}");
+    millisecond_template.insert(extension_index != -1 ? extension_index : millisecond_template.length(), "-{msec}");
+
+    return millisecond_template;
+}
+
+bool NameTemplate::parseField(const QString &fieldName, Field &field)
+{
+    if (fieldName == "year")
+    {
+        field = Field_Year;
+    }
+    else if (fieldName == "month")
+    {
+        field = Field_Month;
+    }
+    else if (fieldName == "day")
+    {
+        field = Field_Day;
+    }
+    else if (fieldName == "hour")
+    {
+        field = Field_Hour;
+    }
+    else if (fieldName == "minute")
+    {
+        field = Field_Minute;
+    }
+    else if (fieldName == "second")
+    {
+        field = Field_Second;
+    }
+    else if (fieldName == "msec")
+    {
+        field = Field_Millisecond;
+    }
+    else if (fieldName == "date")
+    {
+        field = Field_Date;
+    }
+    else if (fieldName == "time")
+    {
+        field = Field_Time;
+    }
+    else if (fieldName == "seq")
+    {
+        field = Field_Sequence;
+    }
+    else if (fieldName == "ext")
+    {
+        field = Field_Extension;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+int NameTemplate::parseNumber(const QString &timestamp, int position, int width)
+{
+    int number = 0;
+    for (int i = position; i < position + width; i++)
+    {
+        int digit = timestamp.at(i).digitValue();
+        if (digit < 0 || digit > 9)
+        {
+            return -1;
+        }
+        number = number * 10 + digit;
+    }
+
+    return number;
+}
+
+int NameTemplate::daysInMonth(int year, int month)
+{
+    static const int DAYS_IN_MONTH[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0))
+    {
+        return 29;
+    }
+
+    return DAYS_IN_MONTH[month - 1];
+}
+
+int NameTemplate::writeNumber(QChar *buffer, int length, int number, int width)
+{
+    if (length == -1)
+    {
+        return -1;
+    }
+
+    // Zero-padded to the width, wider numbers are written whole.
+    char digits[16];
+    int digit_count = 0;
+    unsigned int value = static_cast<unsigned int>(qMax(number, 0));
+    do
+    {
+        digits[digit_count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while (value > 0);
+    int padding = qMax(width - digit_count, 0);
+    if (length + padding + digit_count > MAXIMUM_NAME_LENGTH)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < padding; i++)
+    {
+        buffer[length++] = QLatin1Char('0');
+    }
+    while (digit_count > 0)
+    {
+        buffer[length++] = QLatin1Char(digits[--digit_count]);
+    }
+
+    return length;
+}
+
+int NameTemplate::writeString(QChar *buffer, int length, const QString &string)
+{
+    if (length == -1 || length + string.length() > MAXIMUM_NAME_LENGTH)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < string.length(); i++)
+    {
+        buffer[length++] = string.at(i);
+    }
+
+    return length;
+}
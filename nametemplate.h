@@ -0,0 +1,76 @@
+#ifndef NAMETEMPLATE_H
+#define NAMETEMPLATE_H
+
+// Qt
+#include <QChar>
+#include <QList>
+#include <QString>
+
+// Builds the new file names from a template such as "{date} {time}.{ext}", the default, or "{year}{month}{day}_{seq}.{ext}".
+// Fields: {year} {month} {day} {hour} {minute} {second} {msec} {date} (yyyy-MM-dd) {time} (HH.mm.ss) {seq} {ext}.
+// The template is compiled once into segments, and names are written into a caller supplied buffer
+// with integer arithmetic only, so building a name allocates nothing.
+class NameTemplate
+{
+public:
+    static const QString DEFAULT_TEMPLATE;
+    static const int MAXIMUM_NAME_LENGTH = 255;
+    struct Timestamp
+    {
+        int year;
+        int month;
+        int day;
+        int hour;
+        int minute;
+        int second;
+        int millisecond;
+    };
+
+private:
+    enum Field
+    {
+        Field_Literal,
+        Field_Year,
+        Field_Month,
+        Field_Day,
+        Field_Hour,
+        Field_Minute,
+        Field_Second,
+        Field_Millisecond,
+        Field_Date,
+        Field_Time,
+        Field_Sequence,
+        Field_Extension
+    };
+    struct Segment
+    {
+        Field field;
+        QString literal;
+    };
+    QList<Segment> m_segments;
+    bool m_hasSequence;
+    bool m_hasMillisecond;
+
+public:
+    NameTemplate();
+
+public:
+    bool compile(const QString &nameTemplate, QString *errorString = NULL);
+    bool hasSequence() const;
+    bool hasMillisecond() const;
+    int format(const Timestamp &timestamp, int sequence, const QString &extension, QChar *buffer) const;
+    static bool parseTimestamp(const QString &timestamp, Timestamp &parsedTimestamp);
+    static QString formatTimestamp(const Timestamp &timestamp);
+    static void addSeconds(Timestamp &timestamp, int seconds);
+    static int parseSubSecond(const QString &subSecond);
+    static QString millisecondTemplate(const QString &nameTemplate);
+
+private:
+    static bool parseField(const QString &fieldName, Field &field);
+    static int parseNumber(const QString &timestamp, int position, int width);
+    static int daysInMonth(int year, int month);
+    static int writeNumber(QChar *buffer, int length, int number, int width);
+    static int writeString(QChar *buffer, int length, const QString &string);
+};
+
+#endif // NAMETEMPLATE_H
@@ -0,0 +1,106 @@
+// Local
+#include "nametimestampdecoder.h"
+
+// yyyyMMdd_HHmmss, as in IMG_20150704_183012.jpg.
+const QRegularExpression NameTimestampDecoder::m_DATE_TIME_EXPRESSION("(?<![0-9])([0-9]{8})_([0-9]{6})(?![0-9])");
+// Milliseconds since the epoch, as in 1436027412345.jpg.
+const QRegularExpression NameTimestampDecoder::m_EPOCH_MILLISECONDS_EXPRESSION("^([0-9]{13})(?![0-9])");
+
+bool NameTimestampDecoder::decode(Decoder decoder, const QString &fileName, QString &timestamp)
+{
+    QDateTime date_time;
+    switch (decoder)
+    {
+    case Decoder_DateTime:
+    {
+        QRegularExpressionMatch regular_expression_match = m_DATE_TIME_EXPRESSION.match(fileName);
+        if (!regular_expression_match.hasMatch())
+        {
+            return false;
+        }
+        date_time = QDateTime::fromString(regular_expression_match.captured(1) + regular_expression_match.captured(2), "yyyyMMddHHmmss");
+        break;
+    }
+    case Decoder_EpochMilliseconds:
+    {
+        QRegularExpressionMatch regular_expression_match = m_EPOCH_MILLISECONDS_EXPRESSION.match(fileName);
+        if (!regular_expression_match.hasMatch())
+        {
+            return false;
+        }
+
+        // The epoch is UTC, the names are in local time like the Exif timestamps.
+        date_time = QDateTime::fromMSecsSinceEpoch(regular_expression_match.captured(1).toLongLong()).toLocalTime();
+        break;
+    }
+    case Decoder_None:
+    default:
+        return false;
+    }
+
+    // Reject digits which happen to look like a time.
+    if (!NameTimestampDecoder::isPlausible(date_time))
+    {
+        return false;
+    }
+
+    timestamp = date_time.toString("yyyy-MM-dd HH.mm.ss");
+
+    return true;
+}
+
+bool NameTimestampDecoder::parseMode(const QString &modeName, Mode &mode)
+{
+    if (modeName == "off")
+    {
+        mode = Mode_Off;
+    }
+    else if (modeName == "first")
+    {
+        mode = Mode_First;
+    }
+    else if (modeName == "check")
+    {
+        mode = Mode_CrossCheck;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool NameTimestampDecoder::parseDecoder(const QString &decoderName, Decoder &decoder)
+{
+    if (decoderName.isEmpty() || decoderName == "none")
+    {
+        decoder = Decoder_None;
+    }
+    else if (decoderName == "datetime")
+    {
+        decoder = Decoder_DateTime;
+    }
+    else if (decoderName == "epoch-ms")
+    {
+        decoder = Decoder_EpochMilliseconds;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool NameTimestampDecoder::isPlausible(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid())
+    {
+        return false;
+    }
+
+    int year = dateTime.date().year();
+
+    return year >= 1990 && year <= 2100;
+}
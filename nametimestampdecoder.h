@@ -0,0 +1,40 @@
+#ifndef NAMETIMESTAMPDECODER_H
+#define NAMETIMESTAMPDECODER_H
+
+// Qt
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QString>
+
+// Decodes the capture time from file names which encode it, so these files can be renamed without opening them.
+// Timestamps are returned in the renamer format, "yyyy-MM-dd HH.mm.ss".
+class NameTimestampDecoder
+{
+public:
+    enum Decoder
+    {
+        Decoder_None,
+        Decoder_DateTime,
+        Decoder_EpochMilliseconds
+    };
+    enum Mode
+    {
+        Mode_Off,
+        Mode_First,
+        Mode_CrossCheck
+    };
+
+private:
+    static const QRegularExpression m_DATE_TIME_EXPRESSION;
+    static const QRegularExpression m_EPOCH_MILLISECONDS_EXPRESSION;
+
+public:
+    static bool decode(Decoder decoder, const QString &fileName, QString &timestamp);
+    static bool parseMode(const QString &modeName, Mode &mode);
+    static bool parseDecoder(const QString &decoderName, Decoder &decoder);
+
+private:
+    static bool isPlausible(const QDateTime &dateTime);
+};
+
+#endif // NAMETIMESTAMPDECODER_H
@@ -0,0 +1,185 @@
+// Qt
+#include <QFileInfo>
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+// Windows
+#include <io.h>
+#else
+// Posix
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Local
+#include "renamejournal.h"
+
+const int RenameJournal::DEFAULT_GROUP_SIZE(64);
+
+RenameJournal::RenameJournal() :
+    m_journalFile(),
+    m_groupSize(DEFAULT_GROUP_SIZE),
+    m_pendingEntries(),
+    m_syncCount(0)
+{
+}
+
+RenameJournal::~RenameJournal()
+{
+    this->close();
+}
+
+bool RenameJournal::open(const QString &journalFilePath, bool append)
+{
+    this->close();
+
+    m_journalFile.setFileName(journalFilePath);
+    bool journal_created = !QFileInfo::exists(journalFilePath);
+    if (!m_journalFile.open(append ? QIODevice::WriteOnly | QIODevice::Append : QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    // The entry of a new journal lives in its directory: make it durable too, or a crash may lose the whole file.
+    if (journal_created && !RenameJournal::syncDirectory(journalFilePath))
+    {
+        m_journalFile.close();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool RenameJournal::isOpen() const
+{
+    return m_journalFile.isOpen();
+}
+
+QString RenameJournal::filePath() const
+{
+    return m_journalFile.fileName();
+}
+
+int RenameJournal::groupSize() const
+{
+    return m_groupSize;
+}
+
+void RenameJournal::setGroupSize(int groupSize)
+{
+    m_groupSize = qMax(groupSize, 1);
+}
+
+int RenameJournal::syncCount() const
+{
+    return m_syncCount;
+}
+
+void RenameJournal::add(const QString &from, const QString &to, RenamePlan::Type type)
+{
+    RenamePlan::Entry entry;
+    entry.from = from;
+    entry.to = to;
+    entry.type = type;
+    m_pendingEntries.append(entry);
+}
+
+bool RenameJournal::isGroupFull() const
+{
+    return m_pendingEntries.count() >= m_groupSize;
+}
+
+bool RenameJournal::hasPendingEntries() const
+{
+    return !m_pendingEntries.isEmpty();
+}
+
+bool RenameJournal::commit(QList<RenamePlan::Entry> &entries)
+{
+    // Write the pending group in one go and make it durable.
+    // The group is handed back either way; on failure none of its renames may be performed.
+    entries.clear();
+    entries.swap(m_pendingEntries);
+
+    QByteArray group;
+    foreach (const RenamePlan::Entry &entry, entries)
+    {
+        group += RenamePlan::formatEntry(entry.from, entry.to, entry.type);
+        group += '\n';
+    }
+    if (m_journalFile.write(group) != group.size())
+    {
+        return false;
+    }
+
+    return this->sync();
+}
+
+void RenameJournal::close()
+{
+    if (m_journalFile.isOpen())
+    {
+        m_journalFile.close();
+    }
+    m_pendingEntries.clear();
+}
+
+bool RenameJournal::read(const QString &journalFilePath, QList<RenamePlan::Entry> &entries)
+{
+    QFile journal_file(journalFilePath);
+    if (!journal_file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    // A torn last line (crash in the middle of a write) is simply ignored.
+    while (!journal_file.atEnd())
+    {
+        QByteArray line = journal_file.readLine().trimmed();
+        RenamePlan::Entry entry;
+        if (RenamePlan::parseEntry(line, entry))
+        {
+            entries.append(entry);
+        }
+    }
+
+    return true;
+}
+
+bool RenameJournal::sync()
+{
+    if (!m_journalFile.flush())
+    {
+        return false;
+    }
+
+    m_syncCount++;
+
+#ifdef Q_OS_WIN
+    return _commit(m_journalFile.handle()) == 0;
+#else
+    return fsync(m_journalFile.handle()) == 0;
+#endif
+}
+
+bool RenameJournal::syncDirectory(const QString &filePath)
+{
+#ifdef Q_OS_WIN
+    // Directories can't be synced on Windows, NTFS journals their metadata itself.
+    Q_UNUSED(filePath);
+
+    return true;
+#else
+    int directory_fd = ::open(QFile::encodeName(QFileInfo(filePath).absolutePath()).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory_fd == -1)
+    {
+        return false;
+    }
+
+    bool ret_val = fsync(directory_fd) == 0;
+    ::close(directory_fd);
+
+    return ret_val;
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef RENAMEJOURNAL_H
+#define RENAMEJOURNAL_H
+
+// Qt
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Local
+#include "renameplan.h"
+
+// Write-ahead log of the renames of a run, in the rename plan format.
+// Renames are logged in groups: a whole group is written and synced to disk with
+// one fsync before any of its renames is performed.
+class RenameJournal
+{
+public:
+    static const int DEFAULT_GROUP_SIZE;
+
+private:
+    QFile m_journalFile;
+    int m_groupSize;
+    QList<RenamePlan::Entry> m_pendingEntries;
+    int m_syncCount;
+
+public:
+    RenameJournal();
+    ~RenameJournal();
+
+public:
+    bool open(const QString &journalFilePath, bool append);
+    bool isOpen() const;
+    QString filePath() const;
+    int groupSize() const;
+    void setGroupSize(int groupSize);
+    int syncCount() const;
+    void add(const QString &from, const QString &to, RenamePlan::Type type = RenamePlan::Type_Rename);
+    bool isGroupFull() const;
+    bool hasPendingEntries() const;
+    bool commit(QList<RenamePlan::Entry> &entries);
+    void close();
+    static bool read(const QString &journalFilePath, QList<RenamePlan::Entry> &entries);
+
+private:
+    bool sync();
+    static bool syncDirectory(const QString &filePath);
+};
+
+#endif // RENAMEJOURNAL_H
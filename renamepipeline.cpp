@@ -0,0 +1,321 @@
+// Qt
+#include <QRunnable>
+#include <QThread>
+
+// Local
+#include "directorywalker.h"
+#include "renamepipeline.h"
+
+const int RenamePipeline::m_DEFAULT_QUEUE_CAPACITY(1024);
+
+const char *const RenamePipeline::m_QUEUE_NAMES[Queue_Count] =
+{
+    "scan>classify",
+    "classify>extract",
+    "extract>commit"
+};
+
+class RenamePipeline::Worker : public QRunnable
+{
+private:
+    RenamePipeline *m_renamePipeline;
+    Stage m_stage;
+
+public:
+    Worker(RenamePipeline *renamePipeline, Stage stage) :
+        m_renamePipeline(renamePipeline),
+        m_stage(stage)
+    {
+    }
+
+public:
+    virtual void run()
+    {
+        m_renamePipeline->runStage(m_stage);
+    }
+};
+
+template <typename T>
+void RenamePipeline::push(BoundedQueue<T> &queue, Queue queueId, const T &item)
+{
+    QueueMetrics &queue_metrics = m_queueMetrics[queueId];
+    QueueSlots &queue_slots = m_queueSlots[queueId];
+
+    // A full queue means the next stage is the slower one: block until it takes an item.
+    if (!queue_slots.freeSlots.tryAcquire())
+    {
+        queue_metrics.producerStallCount.fetch_add(1, std::memory_order_relaxed);
+        queue_slots.freeSlots.acquire();
+    }
+
+    // The slot is ours, the cell may only still be in the hands of a consumer finishing its dequeue.
+    while (!queue.tryEnqueue(item))
+    {
+        QThread::yieldCurrentThread();
+    }
+    queue_slots.queuedItems.release();
+
+    qint64 depth = queue_metrics.depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    qint64 maximum_depth = queue_metrics.maximumDepth.load(std::memory_order_relaxed);
+    while (depth > maximum_depth && !queue_metrics.maximumDepth.compare_exchange_weak(maximum_depth, depth, std::memory_order_relaxed))
+    {
+    }
+}
+
+template <typename T>
+bool RenamePipeline::pop(BoundedQueue<T> &queue, Queue queueId, Stage producerStage, T &item)
+{
+    QueueMetrics &queue_metrics = m_queueMetrics[queueId];
+    QueueSlots &queue_slots = m_queueSlots[queueId];
+
+    // An empty queue means the previous stage is the slower one: block until it queues an item,
+    // or until its last thread leaves and wakes every consumer.
+    if (!queue_slots.queuedItems.tryAcquire())
+    {
+        queue_metrics.consumerStallCount.fetch_add(1, std::memory_order_relaxed);
+        queue_slots.queuedItems.acquire();
+    }
+
+    for (;;)
+    {
+        // The producers leave only once everything they made is queued, so check the queue once more after they are gone.
+        bool producers_done = m_activeThreadCounts[producerStage].loadAcquire() == 0;
+        if (queue.tryDequeue(item))
+        {
+            queue_slots.freeSlots.release();
+
+            qint64 depth = queue_metrics.depth.fetch_sub(1, std::memory_order_relaxed);
+            queue_metrics.depthSum.fetch_add(qMax(depth, Q_INT64_C(0)), std::memory_order_relaxed);
+            queue_metrics.itemCount.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+        if (producers_done)
+        {
+            return false;
+        }
+
+        // The item counted is still being published by its producer.
+        QThread::yieldCurrentThread();
+    }
+}
+
+RenamePipeline::RenamePipeline(Handler *handler) :
+    m_handler(handler),
+    m_queueCapacity(m_DEFAULT_QUEUE_CAPACITY),
+    m_recursive(false),
+    m_threadPool(),
+    m_directories(),
+    m_directoryErrorCount(0),
+    m_scannedFiles(),
+    m_classifiedFiles(),
+    m_extractedFiles()
+{
+    for (int stage = 0; stage < Stage_Count; stage++)
+    {
+        m_threadCounts[stage] = 1;
+    }
+    this->resetQueueMetrics();
+}
+
+RenamePipeline::~RenamePipeline()
+{
+    m_threadPool.waitForDone();
+}
+
+int RenamePipeline::threadCount(Stage stage) const
+{
+    return m_threadCounts[stage];
+}
+
+void RenamePipeline::setThreadCount(Stage stage, int threadCount)
+{
+    m_threadCounts[stage] = qMax(threadCount, 1);
+}
+
+int RenamePipeline::queueCapacity() const
+{
+    return m_queueCapacity;
+}
+
+void RenamePipeline::setQueueCapacity(int queueCapacity)
+{
+    m_queueCapacity = qMax(queueCapacity, 2);
+}
+
+void RenamePipeline::setRecursive(bool recursive)
+{
+    m_recursive = recursive;
+}
+
+void RenamePipeline::run(const QList<QDir> &directories)
+{
+    m_scannedFiles.reset(new BoundedQueue<QFileInfo>(m_queueCapacity));
+    m_classifiedFiles.reset(new BoundedQueue<MatchedFile>(m_queueCapacity));
+    m_extractedFiles.reset(new BoundedQueue<ExtractedFile>(m_queueCapacity));
+    m_queueSlots.reset(new QueueSlots[Queue_Count]);
+    for (int queue = 0; queue < Queue_Count; queue++)
+    {
+        m_queueSlots[queue].freeSlots.release(m_queueCapacity);
+    }
+    this->resetQueueMetrics();
+    m_directories = directories;
+    m_directoryErrorCount = 0;
+
+    // Count every thread in before any starts, so no stage sees its producers gone too early.
+    int thread_count = 0;
+    for (int stage = 0; stage < Stage_Count; stage++)
+    {
+        m_activeThreadCounts[stage].store(this->workerCount(static_cast<Stage>(stage)));
+        thread_count += this->workerCount(static_cast<Stage>(stage));
+    }
+    m_threadPool.setMaxThreadCount(thread_count);
+    for (int stage = 0; stage < Stage_Count; stage++)
+    {
+        for (int i = 0; i < this->workerCount(static_cast<Stage>(stage)); i++)
+        {
+            m_threadPool.start(new Worker(this, static_cast<Stage>(stage)));
+        }
+    }
+
+    this->commit();
+
+    m_threadPool.waitForDone();
+}
+
+int RenamePipeline::directoryErrorCount() const
+{
+    return m_directoryErrorCount;
+}
+
+QStringList RenamePipeline::report() const
+{
+    QStringList report;
+    report << QString("Pipeline threads: scan %1, classify %2, extract %3, commit 1")
+              .arg(m_threadCounts[Stage_Scan])
+              .arg(m_threadCounts[Stage_Classify])
+              .arg(m_threadCounts[Stage_Extract]);
+    report << QString("%1 %2 %3 %4 %5 %6 %7")
+              .arg("queue", -16)
+              .arg("capacity", 10)
+              .arg("items", 10)
+              .arg("mean", 10)
+              .arg("max", 10)
+              .arg("full", 10)
+              .arg("empty", 10);
+    for (int queue = 0; queue < Queue_Count; queue++)
+    {
+        const QueueMetrics &queue_metrics = m_queueMetrics[queue];
+        quint64 item_count = queue_metrics.itemCount.load(std::memory_order_relaxed);
+        double mean_depth = item_count > 0 ? static_cast<double>(queue_metrics.depthSum.load(std::memory_order_relaxed)) / item_count : 0.0;
+
+        // Many full stalls point at the consumer of the queue, many empty ones at its producer.
+        report << QString("%1 %2 %3 %4 %5 %6 %7")
+                  .arg(m_QUEUE_NAMES[queue], -16)
+                  .arg(m_queueCapacity, 10)
+                  .arg(item_count, 10)
+                  .arg(mean_depth, 10, 'f', 1)
+                  .arg(queue_metrics.maximumDepth.load(std::memory_order_relaxed), 10)
+                  .arg(queue_metrics.producerStallCount.load(std::memory_order_relaxed), 10)
+                  .arg(queue_metrics.consumerStallCount.load(std::memory_order_relaxed), 10);
+    }
+
+    return report;
+}
+
+int RenamePipeline::workerCount(Stage stage) const
+{
+    // The scanners belong to the directory walker, a single worker feeds what they find to the queue.
+    return stage == Stage_Scan ? 1 : m_threadCounts[stage];
+}
+
+void RenamePipeline::runStage(Stage stage)
+{
+    switch (stage)
+    {
+    case Stage_Scan:
+        this->scan();
+        break;
+    case Stage_Classify:
+        this->classify();
+        break;
+    case Stage_Extract:
+        this->extract();
+        break;
+    default:
+        break;
+    }
+
+    // The last thread of a stage wakes every consumer of its queue, so they see it is done.
+    if (!m_activeThreadCounts[stage].deref())
+    {
+        int consumer_count = stage + 1 < Stage_Count ? m_threadCounts[stage + 1] : 1;
+        m_queueSlots[stage].queuedItems.release(consumer_count);
+    }
+}
+
+void RenamePipeline::scan()
+{
+    DirectoryWalker directory_walker;
+    directory_walker.setRecursive(m_recursive);
+    directory_walker.start(m_directories, m_threadCounts[Stage_Scan]);
+    MatchedFileList files;
+    while (directory_walker.nextBatch(files))
+    {
+        foreach (const MatchedFile &file, files)
+        {
+            this->push(*m_scannedFiles, Queue_Scanned, file.file);
+        }
+    }
+
+    // Read by the calling thread once the pool is done.
+    m_directoryErrorCount = directory_walker.errorCount();
+}
+
+void RenamePipeline::classify()
+{
+    QFileInfo file;
+    while (this->pop(*m_scannedFiles, Queue_Scanned, Stage_Scan, file))
+    {
+        int file_filter_id;
+        if (m_handler->classifyFile(file, file_filter_id))
+        {
+            this->push(*m_classifiedFiles, Queue_Classified, MatchedFile(file, file_filter_id));
+        }
+    }
+}
+
+void RenamePipeline::extract()
+{
+    MatchedFile file;
+    while (this->pop(*m_classifiedFiles, Queue_Classified, Stage_Classify, file))
+    {
+        ExtractedFile extracted_file;
+        extracted_file.file = file.file;
+        extracted_file.timestampExtracted = m_handler->extractTimestamp(file, extracted_file.timestamp);
+        this->push(*m_extractedFiles, Queue_Extracted, extracted_file);
+    }
+}
+
+void RenamePipeline::commit()
+{
+    ExtractedFile extracted_file;
+    while (this->pop(*m_extractedFiles, Queue_Extracted, Stage_Extract, extracted_file))
+    {
+        m_handler->commitFile(extracted_file.file, extracted_file.timestampExtracted, extracted_file.timestamp);
+    }
+}
+
+void RenamePipeline::resetQueueMetrics()
+{
+    for (int queue = 0; queue < Queue_Count; queue++)
+    {
+        QueueMetrics &queue_metrics = m_queueMetrics[queue];
+        queue_metrics.depth.store(0);
+        queue_metrics.maximumDepth.store(0);
+        queue_metrics.depthSum.store(0);
+        queue_metrics.itemCount.store(0);
+        queue_metrics.producerStallCount.store(0);
+        queue_metrics.consumerStallCount.store(0);
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef RENAMEPIPELINE_H
+#define RENAMEPIPELINE_H
+
+// Std
+#include <atomic>
+
+// Qt
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QList>
+#include <QScopedArrayPointer>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QStringList>
+#include <QThreadPool>
+
+// Local
+#include "boundedqueue.h"
+#include "matchedfile.h"
+#include "nametemplate.h"
+
+// Runs the renaming as four stages connected by bounded queues: directory scan, file name
+// classification, metadata extraction and rename commit. The scan is a directory walker on its
+// own number of scanners, classification and extraction each run on their own number of
+// threads, the commit runs on the calling thread, as it owns
+// the journal, the plan and the counters. A full queue blocks its producers, so memory stays
+// flat whichever stage is the slowest, and the queue metrics tell which stage is starving the next.
+class RenamePipeline
+{
+public:
+    // The work of the stages, supplied by the renamer.
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+
+    public:
+        // Called from the classification threads with every file listed, sets the id of the matching filter.
+        virtual bool classifyFile(const QFileInfo &file, int &fileFilterId) = 0;
+        // Called from the extraction threads.
+        virtual bool extractTimestamp(const MatchedFile &file, NameTemplate::Timestamp &timestamp) = 0;
+        // Called from the calling thread.
+        virtual void commitFile(const QFileInfo &file, bool timestampExtracted, const NameTemplate::Timestamp &timestamp) = 0;
+    };
+    enum Stage
+    {
+        Stage_Scan,
+        Stage_Classify,
+        Stage_Extract,
+        Stage_Count
+    };
+
+private:
+    enum Queue
+    {
+        Queue_Scanned,
+        Queue_Classified,
+        Queue_Extracted,
+        Queue_Count
+    };
+    struct ExtractedFile
+    {
+        QFileInfo file;
+        bool timestampExtracted;
+        NameTemplate::Timestamp timestamp;
+    };
+    struct QueueMetrics
+    {
+        std::atomic<qint64> depth;
+        std::atomic<qint64> maximumDepth;
+        std::atomic<quint64> depthSum;
+        std::atomic<quint64> itemCount;
+        std::atomic<quint64> producerStallCount;
+        std::atomic<quint64> consumerStallCount;
+    };
+    struct QueueSlots
+    {
+        QSemaphore freeSlots;
+        QSemaphore queuedItems;
+    };
+    class Worker;
+    static const int m_DEFAULT_QUEUE_CAPACITY;
+    static const char *const m_QUEUE_NAMES[Queue_Count];
+    Handler *m_handler;
+    int m_threadCounts[Stage_Count];
+    int m_queueCapacity;
+    bool m_recursive;
+    QThreadPool m_threadPool;
+    QList<QDir> m_directories;
+    int m_directoryErrorCount;
+    QAtomicInt m_activeThreadCounts[Stage_Count];
+    QueueMetrics m_queueMetrics[Queue_Count];
+    QScopedArrayPointer<QueueSlots> m_queueSlots;
+    QScopedPointer<BoundedQueue<QFileInfo> > m_scannedFiles;
+    QScopedPointer<BoundedQueue<MatchedFile> > m_classifiedFiles;
+    QScopedPointer<BoundedQueue<ExtractedFile> > m_extractedFiles;
+
+public:
+    explicit RenamePipeline(Handler *handler);
+    ~RenamePipeline();
+
+private:
+    RenamePipeline(const RenamePipeline &);
+    RenamePipeline &operator=(const RenamePipeline &);
+
+public:
+    int threadCount(Stage stage) const;
+    void setThreadCount(Stage stage, int threadCount);
+    int queueCapacity() const;
+    void setQueueCapacity(int queueCapacity);
+    void setRecursive(bool recursive);
+    void run(const QList<QDir> &directories);
+    int directoryErrorCount() const;
+    QStringList report() const;
+
+private:
+    int workerCount(Stage stage) const;
+    void runStage(Stage stage);
+    void scan();
+    void classify();
+    void extract();
+    void commit();
+    void resetQueueMetrics();
+    template <typename T>
+    void push(BoundedQueue<T> &queue, Queue queueId, const T &item);
+    template <typename T>
+    bool pop(BoundedQueue<T> &queue, Queue queueId, Stage producerStage, T &item);
+};
+
+#endif // RENAMEPIPELINE_H
@@ -0,0 +1,97 @@
+// Qt
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Local
+#include "renameplan.h"
+
+const QString RenamePlan::m_FROM_KEY("from");
+const QString RenamePlan::m_TO_KEY("to");
+const QString RenamePlan::m_TYPE_KEY("type");
+const QString RenamePlan::m_LINK_TYPE("link");
+
+RenamePlan::RenamePlan() :
+    m_planFile()
+{
+}
+
+RenamePlan::~RenamePlan()
+{
+    this->close();
+}
+
+bool RenamePlan::open(const QString &planFilePath)
+{
+    this->close();
+
+    m_planFile.setFileName(planFilePath);
+
+    return m_planFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+bool RenamePlan::isOpen() const
+{
+    return m_planFile.isOpen();
+}
+
+QString RenamePlan::filePath() const
+{
+    return m_planFile.fileName();
+}
+
+bool RenamePlan::append(const QString &from, const QString &to)
+{
+    QByteArray line = RenamePlan::formatEntry(from, to);
+    line += '\n';
+
+    return m_planFile.write(line) == line.size();
+}
+
+void RenamePlan::close()
+{
+    if (m_planFile.isOpen())
+    {
+        m_planFile.close();
+    }
+}
+
+QByteArray RenamePlan::formatEntry(const QString &from, const QString &to, Type type)
+{
+    QJsonObject json_object;
+    json_object.insert(m_FROM_KEY, from);
+    json_object.insert(m_TO_KEY, to);
+
+    // Renames carry no type, so plans and journals of renames only read as they always did.
+    if (type == Type_Link)
+    {
+        json_object.insert(m_TYPE_KEY, m_LINK_TYPE);
+    }
+
+    return QJsonDocument(json_object).toJson(QJsonDocument::Compact);
+}
+
+bool RenamePlan::parseEntry(const QByteArray &line, Entry &entry)
+{
+    QJsonDocument json_document = QJsonDocument::fromJson(line);
+    if (!json_document.isObject())
+    {
+        return false;
+    }
+
+    QJsonObject json_object = json_document.object();
+    entry.from = json_object.value(m_FROM_KEY).toString();
+    entry.to = json_object.value(m_TO_KEY).toString();
+
+    // An entry of a type this version doesn't know is not taken for a rename.
+    entry.type = Type_Rename;
+    if (json_object.contains(m_TYPE_KEY))
+    {
+        if (json_object.value(m_TYPE_KEY).toString() != m_LINK_TYPE)
+        {
+            return false;
+        }
+        entry.type = Type_Link;
+    }
+
+    return !entry.from.isEmpty() && !entry.to.isEmpty();
+}
@@ -0,0 +1,48 @@
+#ifndef RENAMEPLAN_H
+#define RENAMEPLAN_H
+
+// Qt
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Rename manifest: one JSON object per line, {"from": "<old path>", "to": "<new path>"}.
+// Written by a planning run, read back by the apply step. The rename journal uses the same format,
+// where a "type": "link" entry records a duplicate replaced with a hard link to the file it copies.
+class RenamePlan
+{
+public:
+    enum Type
+    {
+        Type_Rename,
+        Type_Link
+    };
+    struct Entry
+    {
+        QString from;
+        QString to;
+        Type type;
+    };
+
+private:
+    static const QString m_FROM_KEY;
+    static const QString m_TO_KEY;
+    static const QString m_TYPE_KEY;
+    static const QString m_LINK_TYPE;
+    QFile m_planFile;
+
+public:
+    RenamePlan();
+    ~RenamePlan();
+
+public:
+    bool open(const QString &planFilePath);
+    bool isOpen() const;
+    QString filePath() const;
+    bool append(const QString &from, const QString &to);
+    void close();
+    static QByteArray formatEntry(const QString &from, const QString &to, Type type = Type_Rename);
+    static bool parseEntry(const QByteArray &line, Entry &entry);
+};
+
+#endif // RENAMEPLAN_H
@@ -0,0 +1,196 @@
+// Local
+#include "renamestatistics.h"
+
+const char *const RenameStatistics::m_STAGE_NAMES[Stage_Count] =
+{
+    "filter match",
+    "cache lookup",
+    "exif read",
+    "image open",
+    "read metadata",
+    "name probe",
+    "rename"
+};
+
+const char *const RenameStatistics::m_ROUTE_NAMES[Route_Count] =
+{
+    "jpeg fast path",
+    "jpeg",
+    "tiff",
+    "png",
+    "no exif",
+    "probe"
+};
+
+RenameStatistics::StageTimer::StageTimer(RenameStatistics &renameStatistics, Stage stage) :
+    m_renameStatistics(renameStatistics),
+    m_stage(stage),
+    m_elapsedTimer()
+{
+    if (m_renameStatistics.isEnabled())
+    {
+        m_elapsedTimer.start();
+    }
+}
+
+RenameStatistics::StageTimer::~StageTimer()
+{
+    if (m_elapsedTimer.isValid())
+    {
+        m_renameStatistics.record(m_stage, m_elapsedTimer.nsecsElapsed());
+    }
+}
+
+RenameStatistics::RenameStatistics() :
+    m_enabled(false)
+{
+    for (int stage = 0; stage < Stage_Count; stage++)
+    {
+        for (int bucket = 0; bucket < m_BUCKET_COUNT; bucket++)
+        {
+            m_bucketCounts[stage][bucket].store(0);
+        }
+        m_totalNs[stage].store(0);
+        m_maximumNs[stage].store(0);
+    }
+    for (int route = 0; route < Route_Count; route++)
+    {
+        m_routeCounts[route].store(0);
+    }
+}
+
+bool RenameStatistics::isEnabled() const
+{
+    return m_enabled;
+}
+
+void RenameStatistics::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+void RenameStatistics::record(Stage stage, qint64 elapsedNs)
+{
+    quint64 elapsed_ns = elapsedNs > 0 ? static_cast<quint64>(elapsedNs) : 0;
+
+    // Bucket i holds durations in [2^i, 2^(i+1)) ns.
+    int bucket = 0;
+    while (bucket < m_BUCKET_COUNT - 1 && (elapsed_ns >> (bucket + 1)) != 0)
+    {
+        bucket++;
+    }
+
+    m_bucketCounts[stage][bucket].fetch_add(1, std::memory_order_relaxed);
+    m_totalNs[stage].fetch_add(elapsed_ns, std::memory_order_relaxed);
+    quint64 maximum_ns = m_maximumNs[stage].load(std::memory_order_relaxed);
+    while (elapsed_ns > maximum_ns && !m_maximumNs[stage].compare_exchange_weak(maximum_ns, elapsed_ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+quint64 RenameStatistics::count(Stage stage) const
+{
+    quint64 stage_count = 0;
+    for (int bucket = 0; bucket < m_BUCKET_COUNT; bucket++)
+    {
+        stage_count += m_bucketCounts[stage][bucket].load(std::memory_order_relaxed);
+    }
+
+    return stage_count;
+}
+
+void RenameStatistics::countRoute(Route route)
+{
+    if (m_enabled)
+    {
+        m_routeCounts[route].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+quint64 RenameStatistics::routeCount(Route route) const
+{
+    return m_routeCounts[route].load(std::memory_order_relaxed);
+}
+
+QStringList RenameStatistics::report() const
+{
+    QStringList report;
+    report << QString("%1 %2 %3 %4 %5 %6 %7")
+              .arg("stage", -14)
+              .arg("count", 10)
+              .arg("total", 10)
+              .arg("mean", 10)
+              .arg("p50", 10)
+              .arg("p99", 10)
+              .arg("max", 10);
+    for (int stage = 0; stage < Stage_Count; stage++)
+    {
+        quint64 stage_count = this->count(static_cast<Stage>(stage));
+        if (stage_count == 0)
+        {
+            continue;
+        }
+
+        quint64 total_ns = m_totalNs[stage].load(std::memory_order_relaxed);
+        report << QString("%1 %2 %3 %4 %5 %6 %7")
+                  .arg(m_STAGE_NAMES[stage], -14)
+                  .arg(stage_count, 10)
+                  .arg(RenameStatistics::formatDuration(total_ns), 10)
+                  .arg(RenameStatistics::formatDuration(total_ns / stage_count), 10)
+                  .arg(RenameStatistics::formatDuration(this->percentileNs(static_cast<Stage>(stage), 0.50)), 10)
+                  .arg(RenameStatistics::formatDuration(this->percentileNs(static_cast<Stage>(stage), 0.99)), 10)
+                  .arg(RenameStatistics::formatDuration(m_maximumNs[stage].load(std::memory_order_relaxed)), 10);
+    }
+    report << QString("%1 %2")
+              .arg("route", -14)
+              .arg("count", 10);
+    for (int route = 0; route < Route_Count; route++)
+    {
+        quint64 route_count = this->routeCount(static_cast<Route>(route));
+        if (route_count == 0)
+        {
+            continue;
+        }
+
+        report << QString("%1 %2")
+                  .arg(m_ROUTE_NAMES[route], -14)
+                  .arg(route_count, 10);
+    }
+
+    return report;
+}
+
+quint64 RenameStatistics::percentileNs(Stage stage, double ratio) const
+{
+    // Upper bound of the bucket holding the requested rank.
+    quint64 rank = static_cast<quint64>(this->count(stage) * ratio);
+    quint64 cumulative_count = 0;
+    for (int bucket = 0; bucket < m_BUCKET_COUNT; bucket++)
+    {
+        cumulative_count += m_bucketCounts[stage][bucket].load(std::memory_order_relaxed);
+        if (cumulative_count > rank)
+        {
+            return (Q_UINT64_C(1) << (bucket + 1)) - 1;
+        }
+    }
+
+    return m_maximumNs[stage].load(std::memory_order_relaxed);
+}
+
+QString RenameStatistics::formatDuration(quint64 durationNs)
+{
+    if (durationNs < 10000)
+    {
+        return QString::number(durationNs) + " ns";
+    }
+    if (durationNs < 10000000)
+    {
+        return QString::number(durationNs / 1000) + " us";
+    }
+    if (durationNs < Q_UINT64_C(10000000000))
+    {
+        return QString::number(durationNs / 1000000) + " ms";
+    }
+
+    return QString::number(durationNs / 1000000000) + " s";
+}
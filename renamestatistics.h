@@ -0,0 +1,84 @@
+#ifndef RENAMESTATISTICS_H
+#define RENAMESTATISTICS_H
+
+// Std
+#include <atomic>
+
+// Qt
+#include <QElapsedTimer>
+#include <QStringList>
+
+// Per-stage timing of the rename pipeline, aggregated into log2 histograms of nanoseconds,
+// along with how many files took each extraction route.
+// Recording is lock-free, so the worker threads of the parallel mode can use it too,
+// and it costs nothing but a flag test when disabled.
+class RenameStatistics
+{
+public:
+    enum Stage
+    {
+        Stage_FilterMatch,
+        Stage_CacheLookup,
+        Stage_ExifRead,
+        Stage_ImageOpen,
+        Stage_ReadMetadata,
+        Stage_NameProbe,
+        Stage_Rename,
+        Stage_Count
+    };
+    enum Route
+    {
+        Route_JpegFastPath,
+        Route_Jpeg,
+        Route_Tiff,
+        Route_Png,
+        Route_NoExif,
+        Route_Probe,
+        Route_Count
+    };
+
+    // Times one stage from construction to destruction.
+    class StageTimer
+    {
+    private:
+        RenameStatistics &m_renameStatistics;
+        Stage m_stage;
+        QElapsedTimer m_elapsedTimer;
+
+    public:
+        StageTimer(RenameStatistics &renameStatistics, Stage stage);
+        ~StageTimer();
+    };
+
+private:
+    static const int m_BUCKET_COUNT = 40;
+    static const char *const m_STAGE_NAMES[Stage_Count];
+    static const char *const m_ROUTE_NAMES[Route_Count];
+    bool m_enabled;
+    std::atomic<quint64> m_bucketCounts[Stage_Count][m_BUCKET_COUNT];
+    std::atomic<quint64> m_totalNs[Stage_Count];
+    std::atomic<quint64> m_maximumNs[Stage_Count];
+    std::atomic<quint64> m_routeCounts[Route_Count];
+
+public:
+    RenameStatistics();
+
+private:
+    RenameStatistics(const RenameStatistics &);
+    RenameStatistics &operator=(const RenameStatistics &);
+
+public:
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    void record(Stage stage, qint64 elapsedNs);
+    quint64 count(Stage stage) const;
+    void countRoute(Route route);
+    quint64 routeCount(Route route) const;
+    QStringList report() const;
+
+private:
+    quint64 percentileNs(Stage stage, double ratio) const;
+    static QString formatDuration(quint64 durationNs);
+};
+
+#endif // RENAMESTATISTICS_H
@@ -0,0 +1,331 @@
+// Qt
+#include <QFileInfo>
+
+// Std
+#include <cstring>
+
+// Local
+#include "windowedfileio.h"
+
+const long WindowedFileIo::m_WINDOW_SIZE(64 * 1024);
+const long WindowedFileIo::m_MAXIMUM_WINDOW_SIZE(4 * 1024 * 1024);
+
+WindowedFileIo::WindowedFileIo(const QString &filePath) :
+    m_filePath(filePath),
+    m_file(filePath),
+    m_fileSize(QFileInfo(filePath).size()),
+    m_window(),
+    m_windowOffset(0),
+    m_position(0),
+    m_eof(false),
+    m_error(0),
+    m_mappedData(NULL),
+    m_bytesRead(0),
+    m_bytesMapped(0)
+{
+}
+
+WindowedFileIo::~WindowedFileIo()
+{
+    this->close();
+}
+
+qint64 WindowedFileIo::bytesRead() const
+{
+    return m_bytesRead;
+}
+
+qint64 WindowedFileIo::bytesMapped() const
+{
+    return m_bytesMapped;
+}
+
+int WindowedFileIo::open()
+{
+    // Reopening rewinds, the window is kept as the file is not expected to change in between.
+    if (!m_file.isOpen() && !m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+    {
+        m_error = 1;
+
+        return 1;
+    }
+
+    m_fileSize = m_file.size();
+    m_position = 0;
+    m_eof = false;
+    m_error = 0;
+
+    return 0;
+}
+
+int WindowedFileIo::close()
+{
+    this->munmap();
+    m_file.close();
+
+    return 0;
+}
+
+long WindowedFileIo::write(const Exiv2::byte *data, long wcount)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(wcount);
+
+    return 0;
+}
+
+long WindowedFileIo::write(Exiv2::BasicIo &src)
+{
+    Q_UNUSED(src);
+
+    return 0;
+}
+
+int WindowedFileIo::putb(Exiv2::byte data)
+{
+    Q_UNUSED(data);
+
+    return EOF;
+}
+
+Exiv2::DataBuf WindowedFileIo::read(long rcount)
+{
+    Exiv2::DataBuf data_buf(qMax(rcount, 0L));
+    data_buf.size_ = this->read(data_buf.pData_, data_buf.size_);
+
+    return data_buf;
+}
+
+long WindowedFileIo::read(Exiv2::byte *buf, long rcount)
+{
+    if (!m_file.isOpen())
+    {
+        m_error = 1;
+
+        return 0;
+    }
+
+    // Clip the read to the end of the file.
+    long available_count = static_cast<long>(qMax(m_fileSize - m_position, Q_INT64_C(0)));
+    long read_count = qMin(rcount, available_count);
+    if (read_count <= 0)
+    {
+        m_eof = rcount > 0;
+
+        return 0;
+    }
+
+    long copied_count = 0;
+    if (read_count > m_MAXIMUM_WINDOW_SIZE)
+    {
+        // Too large for the window, read straight into the caller's buffer.
+        copied_count = this->readAt(m_position, reinterpret_cast<char *>(buf), read_count);
+    }
+    else
+    {
+        long window_end = m_windowOffset + m_window.size();
+        if (m_position < m_windowOffset || m_position + read_count > window_end)
+        {
+            this->fillWindow(m_position, read_count);
+        }
+
+        long window_index = m_position - m_windowOffset;
+        if (window_index >= 0 && window_index < m_window.size())
+        {
+            copied_count = qMin(read_count, static_cast<long>(m_window.size()) - window_index);
+            std::memcpy(buf, m_window.constData() + window_index, copied_count);
+        }
+    }
+
+    m_position += copied_count;
+    if (copied_count < rcount)
+    {
+        m_eof = true;
+    }
+
+    return copied_count;
+}
+
+int WindowedFileIo::getb()
+{
+    Exiv2::byte data;
+    if (this->read(&data, 1) != 1)
+    {
+        return EOF;
+    }
+
+    return data;
+}
+
+void WindowedFileIo::transfer(Exiv2::BasicIo &src)
+{
+    Q_UNUSED(src);
+
+    throw Exiv2::Error(1, "Cannot write to " + this->path() + ": windowed file I/O is read-only");
+}
+
+#if defined(_MSC_VER)
+int WindowedFileIo::seek(int64_t offset, Exiv2::BasicIo::Position pos)
+#else
+int WindowedFileIo::seek(long offset, Exiv2::BasicIo::Position pos)
+#endif
+{
+    qint64 new_position = offset;
+    if (pos == Exiv2::BasicIo::cur)
+    {
+        new_position += m_position;
+    }
+    else if (pos == Exiv2::BasicIo::end)
+    {
+        new_position += m_fileSize;
+    }
+    if (new_position < 0)
+    {
+        return 1;
+    }
+
+    // Seeking is free, nothing is read until the next read.
+    m_position = static_cast<long>(new_position);
+    m_eof = false;
+
+    return 0;
+}
+
+Exiv2::byte *WindowedFileIo::mmap(bool isWriteable)
+{
+    if (isWriteable)
+    {
+        throw Exiv2::Error(1, "Cannot map " + this->path() + " for writing: windowed file I/O is read-only");
+    }
+
+    // An empty file cannot be mapped: hand out an empty mapping, nothing may be read from it anyway.
+    if (m_fileSize == 0)
+    {
+        static Exiv2::byte empty_mapping = 0;
+
+        return &empty_mapping;
+    }
+
+    // The kernel only pages in what the parser touches.
+    if (m_mappedData == NULL)
+    {
+        m_mappedData = m_file.map(0, m_fileSize);
+        if (m_mappedData == NULL)
+        {
+            throw Exiv2::Error(2, this->path(), m_file.errorString().toStdString(), "map");
+        }
+        m_bytesMapped += m_fileSize;
+    }
+
+    return m_mappedData;
+}
+
+int WindowedFileIo::munmap()
+{
+    if (m_mappedData == NULL)
+    {
+        return 0;
+    }
+
+    bool ret_val = m_file.unmap(m_mappedData);
+    m_mappedData = NULL;
+
+    return ret_val ? 0 : 1;
+}
+
+long WindowedFileIo::tell() const
+{
+    return m_position;
+}
+
+long WindowedFileIo::size() const
+{
+    return static_cast<long>(m_fileSize);
+}
+
+bool WindowedFileIo::isopen() const
+{
+    return m_file.isOpen();
+}
+
+int WindowedFileIo::error() const
+{
+    return m_error;
+}
+
+bool WindowedFileIo::eof() const
+{
+    return m_eof;
+}
+
+std::string WindowedFileIo::path() const
+{
+    return m_filePath.toStdString();
+}
+
+#ifdef EXV_UNICODE_PATH
+std::wstring WindowedFileIo::wpath() const
+{
+    return m_filePath.toStdWString();
+}
+#endif
+
+Exiv2::BasicIo::AutoPtr WindowedFileIo::temporary() const
+{
+    // Nothing is ever written back through this class, an in-memory scratch is all a caller can need.
+    return Exiv2::BasicIo::AutoPtr(new Exiv2::MemIo);
+}
+
+void WindowedFileIo::populateFakeData()
+{
+}
+
+long WindowedFileIo::readAt(long offset, char *data, long count)
+{
+    if (!m_file.seek(offset))
+    {
+        m_error = 1;
+
+        return 0;
+    }
+
+    qint64 read_count = m_file.read(data, count);
+    if (read_count < 0)
+    {
+        m_error = 1;
+
+        return 0;
+    }
+    m_bytesRead += read_count;
+
+    return static_cast<long>(read_count);
+}
+
+bool WindowedFileIo::fillWindow(long offset, long count)
+{
+    long window_end = m_windowOffset + m_window.size();
+    if (offset >= m_windowOffset && offset <= window_end && offset + count - m_windowOffset <= m_MAXIMUM_WINDOW_SIZE)
+    {
+        // The read continues the window: grow it, doubling so a sequential parse takes few reads.
+        long missing_count = offset + count - window_end;
+        long growth = qMax(missing_count, qMax(static_cast<long>(m_window.size()), m_WINDOW_SIZE));
+        growth = qMin(growth, m_MAXIMUM_WINDOW_SIZE - static_cast<long>(m_window.size()));
+        growth = qMin(growth, static_cast<long>(m_fileSize - window_end));
+
+        int window_size = m_window.size();
+        m_window.resize(window_size + growth);
+        long read_count = this->readAt(window_end, m_window.data() + window_size, growth);
+        m_window.resize(window_size + read_count);
+
+        return read_count == growth;
+    }
+
+    // The read is elsewhere: move the window there.
+    long window_size = static_cast<long>(qMin(static_cast<qint64>(qMax(count, m_WINDOW_SIZE)), m_fileSize - offset));
+    m_window.resize(window_size);
+    m_windowOffset = offset;
+    long read_count = this->readAt(offset, m_window.data(), window_size);
+    m_window.resize(read_count);
+
+    return read_count == window_size;
+}
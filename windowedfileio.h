@@ -0,0 +1,79 @@
+#ifndef WINDOWEDFILEIO_H
+#define WINDOWEDFILEIO_H
+
+// Qt
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Exiv2
+#include <exiv2/exiv2.hpp>
+
+// Read-only Exiv2 I/O which serves reads from a window of the file instead of the whole file.
+// The window starts small and grows as the parser reads on, a read far from it moves it,
+// so parsing the metadata of a large image only pulls the blocks holding the metadata.
+// Mapping (which some formats ask for) maps the file without reading it.
+class WindowedFileIo : public Exiv2::BasicIo
+{
+private:
+    static const long m_WINDOW_SIZE;
+    static const long m_MAXIMUM_WINDOW_SIZE;
+    QString m_filePath;
+    QFile m_file;
+    qint64 m_fileSize;
+    QByteArray m_window;
+    long m_windowOffset;
+    long m_position;
+    bool m_eof;
+    int m_error;
+    uchar *m_mappedData;
+    qint64 m_bytesRead;
+    qint64 m_bytesMapped;
+
+public:
+    explicit WindowedFileIo(const QString &filePath);
+    virtual ~WindowedFileIo();
+
+private:
+    WindowedFileIo(const WindowedFileIo &);
+    WindowedFileIo &operator=(const WindowedFileIo &);
+
+public:
+    qint64 bytesRead() const;
+    qint64 bytesMapped() const;
+
+public:
+    virtual int open();
+    virtual int close();
+    virtual long write(const Exiv2::byte *data, long wcount);
+    virtual long write(Exiv2::BasicIo &src);
+    virtual int putb(Exiv2::byte data);
+    virtual Exiv2::DataBuf read(long rcount);
+    virtual long read(Exiv2::byte *buf, long rcount);
+    virtual int getb();
+    virtual void transfer(Exiv2::BasicIo &src);
+#if defined(_MSC_VER)
+    virtual int seek(int64_t offset, Exiv2::BasicIo::Position pos);
+#else
+    virtual int seek(long offset, Exiv2::BasicIo::Position pos);
+#endif
+    virtual Exiv2::byte *mmap(bool isWriteable = false);
+    virtual int munmap();
+    virtual long tell() const;
+    virtual long size() const;
+    virtual bool isopen() const;
+    virtual int error() const;
+    virtual bool eof() const;
+    virtual std::string path() const;
+#ifdef EXV_UNICODE_PATH
+    virtual std::wstring wpath() const;
+#endif
+    virtual Exiv2::BasicIo::AutoPtr temporary() const;
+    virtual void populateFakeData();
+
+private:
+    long readAt(long offset, char *data, long count);
+    bool fillWindow(long offset, long count);
+};
+
+#endif // WINDOWEDFILEIO_H